@@ -1,7 +1,10 @@
 #ifndef AUTOMATIC_DIFFERENTIATION_AD_BINARY_TENSOR_H_
 #define AUTOMATIC_DIFFERENTIATION_AD_BINARY_TENSOR_H_
 
+#include <algorithm>
+#include <functional>
 #include <locale>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -9,6 +12,8 @@
 #include "automatic_differentiation/ad_expression_tensor.h"
 #include "automatic_differentiation/ad_tensor.h"
 #include "automatic_differentiation/ad_var_tensor.h"
+#include "tensor/contraction_plan.h"
+#include "tensor/einsum.h"
 #include "util/clonable.h"
 #include "util/util.h"
 
@@ -51,8 +56,9 @@ class AD<T>::Binary : public Expression {
     return term1().dependsOn(var) || term2().dependsOn(var);;
   }
 
-  // Evaluate the expression.
-  AD<T> evaluateAtImpl(const VarValues& varValues) const final;
+  // Evaluate the expression.  Multiply overrides this to evaluate a chain of
+  // products at once.
+  AD<T> evaluateAtImpl(const VarValues& varValues) const;
 
   virtual const Shape& shapeTerm1Impl() const = 0;
   virtual const Shape& shapeTerm2Impl() const = 0;
@@ -66,40 +72,17 @@ AD<T> AD<T>::Binary::differentiateImpl(const AD<T>& var) const {
   // TODO(alvin) Only reverse mode at the moment. Consider implementing forward
   // mode.
 
-  Indices indices11(this->shape().nDimensions() + shapeTerm1().nDimensions());
-  Indices indices12(shapeTerm1().nDimensions() + var.shape().nDimensions());
-  Indices indices21(this->shape().nDimensions() + shapeTerm2().nDimensions());
-  Indices indices22(shapeTerm2().nDimensions() + var.shape().nDimensions());
+  const auto& indices1 = chainRuleIndices(this->shape().nDimensions(),
+                                          shapeTerm1().nDimensions(),
+                                          var.shape().nDimensions());
+  const auto& indices2 = chainRuleIndices(this->shape().nDimensions(),
+                                          shapeTerm2().nDimensions(),
+                                          var.shape().nDimensions());
 
-  // dF1 has shape {resultShape, term1Shape} d/dvar has shape {term1Shape, var}
-  const auto resultDimensions = this->shape().nDimensions();
-  for (auto index = 0ul; index < indices11.size(); ++index) {
-    indices11[index] = static_cast<int>(
-        index < resultDimensions ? index : resultDimensions - index - 1);
-  }
-
-  for (auto index = 0ul; index < indices12.size(); ++index) {
-    indices12[index] = static_cast<int>(
-        index < shapeTerm1().nDimensions()
-            ? -index - 1
-            : index - shapeTerm1().nDimensions() + resultDimensions);
-  }
-
-  for (auto index = 0ul; index < indices21.size(); ++index) {
-    indices21[index] = static_cast<int>(
-        index < resultDimensions ? index : resultDimensions - index - 1);
-  }
-
-  for (auto index = 0ul; index < indices22.size(); ++index) {
-    indices22[index] = static_cast<int>(
-        index < shapeTerm2().nDimensions()
-            ? -index - 1
-            : index - shapeTerm2().nDimensions() + resultDimensions);
-  }
-
-  auto result =
-      multiply(dF1(), indices11, term1().differentiate(var), indices12) +
-      multiply(dF2(), indices21, term2().differentiate(var), indices22);
+  auto result = multiply(dF1(), indices1.first, term1().differentiate(var),
+                         indices1.second) +
+                multiply(dF2(), indices2.first, term2().differentiate(var),
+                         indices2.second);
 
   return result.simplify();
 }
@@ -317,13 +300,9 @@ class Multiply : public AD<T>::Binary {
         multiplyShapes(term1.shape(), indices1, term2.shape(), indices2);
   }
 
+  // multiply() picks the storage of the result.
   T f(const T& value1, const T& value2) const final {
-    // Multiply mimics the return type of value1.
-    // We return sparse if possible.
-    return (value1.template isType<typename T::Dense>() &&
-            value2.template isType<typename T::Sparse>())
-               ? multiply(value2, indices2(), value1, indices1())
-               : multiply(value1, indices1(), value2, indices2());
+    return multiply(value1, indices1(), value2, indices2());
   }
   AD<T> dF1() const final {
     auto eyeIndex = Indices(2 * indices1().size());
@@ -367,6 +346,12 @@ class Multiply : public AD<T>::Binary {
 
   AD<T> simplifyImpl() const final;
 
+  // Evaluate the products below this one, e.g. the nested multiplies of the
+  // chain rule, as one einsum so that their order is planned rather than set
+  // by the expression tree.
+  AD<T> evaluateAtImpl(
+      const typename AD<T>::VarValues& varValues) const final;
+
   Indices indices1_;
   Indices indices2_;
   Shape resultShape_;
@@ -401,6 +386,82 @@ AD<T> Multiply<T>::simplifyImpl() const {
   return multiply(term1, indices1(), term2, indices2());
 }
 
+template <typename T>
+AD<T> Multiply<T>::evaluateAtImpl(
+    const typename AD<T>::VarValues& varValues) const {
+  using Const = typename AD<T>::Const;
+
+  // The factors of the products, labelled as einsum indices: the dimensions
+  // of this result are 0, 1, ..., each summed index of each product gets its
+  // own negative label.
+  std::vector<AD<T>> factors;
+  std::vector<Indices> labels;
+  auto next_label = -1;
+  std::function<void(const Multiply&, const Indices&)> flatten =
+      [&](const Multiply& product, const Indices& product_labels) {
+        std::map<int, int> summed;
+        for (const auto* term : {&product.term1(), &product.term2()}) {
+          const auto& indices = term == &product.term1() ? product.indices1()
+                                                         : product.indices2();
+          Indices term_labels;
+          for (const auto index : indices) {
+            if (index >= 0) {
+              term_labels.push_back(
+                  product_labels[static_cast<size_t>(index)]);
+            } else {
+              const auto iter = summed.emplace(index, next_label).first;
+              if (iter->second == next_label) --next_label;
+              term_labels.push_back(iter->second);
+            }
+          }
+
+          if (term->template isType<Multiply>()) {
+            flatten(term->template reference<Multiply>(), term_labels);
+          } else {
+            factors.push_back(term->template isType<Const>()
+                                  ? *term
+                                  : term->evaluateAt(varValues).simplify());
+            labels.push_back(term_labels);
+          }
+        }
+      };
+  Indices result_labels(this->shape().nDimensions());
+  std::iota(result_labels.begin(), result_labels.end(), 0);
+  flatten(*this, result_labels);
+
+  const auto all_const =
+      std::all_of(factors.cbegin(), factors.cend(), [](const AD<T>& factor) {
+        return factor.template isType<Const>();
+      });
+  if (factors.size() > 2 && all_const && !result_labels.empty()) {
+    std::vector<const T*> values;
+    for (const auto& factor : factors) {
+      values.push_back(&factor.template reference<Const>().value());
+    }
+    return AD<T>(einsum(values, labels));
+  }
+
+  // Otherwise multiply the evaluated factors as the tree does.
+  auto next_factor = factors.cbegin();
+  std::function<AD<T>(const Multiply&)> rebuild =
+      [&](const Multiply& product) {
+        std::vector<AD<T>> terms;
+        for (const auto* term : {&product.term1(), &product.term2()}) {
+          terms.push_back(term->template isType<Multiply>()
+                              ? rebuild(term->template reference<Multiply>())
+                              : *next_factor++);
+        }
+        if (terms[0].template isType<Const>() &&
+            terms[1].template isType<Const>()) {
+          return AD<T>(product.f(value(terms[0]), value(terms[1])));
+        }
+        return multiply(terms[0], product.indices1(), terms[1],
+                        product.indices2())
+            .simplify();
+      };
+  return rebuild(*this);
+}
+
 template <typename T>
 AD<T> multiply(const AD<T>& term1, const Indices& indices1, const AD<T>& term2,
                const Indices& indices2) {
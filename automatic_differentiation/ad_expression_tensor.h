@@ -3,15 +3,23 @@
 
 #include <memory>
 #include <string>
+#include <typeinfo>
 
 #include "automatic_differentiation/ad_tensor.h"
+#include "util/arena.h"
 #include "util/clonable.h"
+#include "util/profiler.h"
 
 namespace Alexandria {
 
 // Abstract expression class.
+//
+// Expression nodes are allocated from Arena::current() when an arena is in
+// scope.  Calls to differentiate, evaluateAt and simplify are recorded by
+// Profiler::current() when a profiler is in scope.
 template <typename T>
-class AD<T>::Expression : public Clonable<AD<T>::Expression> {
+class AD<T>::Expression : public Clonable<AD<T>::Expression>,
+                          public ArenaAllocated {
  public:
   using VarValues = AD<T>::VarValues;
 
@@ -25,6 +33,7 @@ class AD<T>::Expression : public Clonable<AD<T>::Expression> {
     CHECK(var.isType<typename AD<T>::Var>() ||
           var.isType<typename AD<T>::Param>())
         << "must be of type Var or Param";
+    ProfileScope scope("differentiate", typeid(*this));
     return differentiateImpl(var);
   }
 
@@ -42,11 +51,21 @@ class AD<T>::Expression : public Clonable<AD<T>::Expression> {
       CHECK(varValue.first.template isType<typename AD<T>::Var>())
           << "must be of type Var";
     }
-    return evaluateAtImpl(varValues);
+    ProfileScope scope("evaluateAt", typeid(*this));
+    auto result = evaluateAtImpl(varValues);
+    if (scope.active() && result.template isType<typename AD<T>::Const>()) {
+      const auto& value =
+          result.template reference<typename AD<T>::Const>().value();
+      scope.setOutput(storageName(value), value.size());
+    }
+    return result;
   }
 
   // Simplify the (sub) expression.
-  AD<T> simplify() const { return simplifyImpl(); }
+  AD<T> simplify() const {
+    ProfileScope scope("simplify", typeid(*this));
+    return simplifyImpl();
+  }
 
   // Shape of the result.
   const Shape& shape() const { return shapeImpl(); }
@@ -8,6 +8,7 @@
 #include "automatic_differentiation/ad_expression_tensor.h"
 #include "automatic_differentiation/ad_tensor.h"
 #include "automatic_differentiation/ad_var_tensor.h"
+#include "tensor/contraction_plan.h"
 #include "util/clonable.h"
 
 namespace Alexandria {
@@ -57,23 +58,11 @@ template <typename T>
 AD<T> AD<T>::Unary::differentiateImpl(const AD<T>& var) const {
   // TODO(alvin) Only reverse mode at the moment. Consider implementing forward
   // mode.
-  Indices indices1(this->shape().nDimensions() + shapeTerm().nDimensions());
-  Indices indices2(shapeTerm().nDimensions() + var.shape().nDimensions());
-
-  const auto resultDimensions = this->shape().nDimensions();
-  for (auto index = 0ul; index < indices1.size(); ++index) {
-    indices1[index] = static_cast<int>(
-        index < resultDimensions ? index : resultDimensions - index - 1);
-  }
-
-  for (auto index = 0ul; index < indices2.size(); ++index) {
-    indices2[index] = static_cast<int>(index < shapeTerm().nDimensions()
-                                           ? -index - 1
-                                           : index - shapeTerm().nDimensions() +
-                                                 resultDimensions);
-  }
-
-  auto result = multiply(dF(), indices1, term().differentiate(var), indices2);
+  const auto& indices = chainRuleIndices(this->shape().nDimensions(),
+                                         shapeTerm().nDimensions(),
+                                         var.shape().nDimensions());
+  auto result = multiply(dF(), indices.first, term().differentiate(var),
+                         indices.second);
   return result.simplify();
 }
 
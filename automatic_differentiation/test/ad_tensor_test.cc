@@ -1,6 +1,8 @@
 #include <cmath>
+#include <random>
 
 #include "automatic_differentiation/ad_tensor.h"
+#include "util/profiler.h"
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wundef"
@@ -195,6 +197,94 @@ TEST(AD, Param) {
             multiply(T({1, 2, 4}), {2}, T::sparseEye(Shape({3, 3})), {0, 1}));
 }
 
+TEST(AD, Profiler) {
+  using T = Alexandria::Tensor<double>;
+  using AD = Alexandria::AD<T>;
+  using Alexandria::Profiler;
+  using Alexandria::Shape;
+
+  auto x = AD("x", Shape({3}));
+  auto expr = sigmoid(x) + x;
+
+  Profiler profiler;
+  EXPECT_EQ(value(expr.evaluateAt({x = T({0, 0, 0})})), T({0.5, 0.5, 0.5}));
+
+  const auto& events = profiler.events();
+  ASSERT_FALSE(events.empty());
+  EXPECT_EQ(events[0].category, "evaluateAt");
+  EXPECT_EQ(events[0].name, "Plus");
+  EXPECT_EQ(events[0].parent, Profiler::kNoParent);
+  EXPECT_EQ(events[0].storage, "dense");
+  EXPECT_EQ(events[0].nnz, 3);
+
+  const auto summary = profiler.summary();
+  EXPECT_EQ(summary.at({"evaluateAt", "Var"}).calls, 2);
+  EXPECT_EQ(summary.at({"evaluateAt", "Sigmoid"}).calls, 1);
+}
+
+TEST(AD, MultiplyChain) {
+  using T = Alexandria::Tensor<double>;
+  using AD = Alexandria::AD<T>;
+  using Alexandria::Shape;
+
+  const auto a = T::fill(Shape({2, 30}), 1.0);
+  const auto b = T::fill(Shape({30, 2}), 2.0);
+  const auto c = T::fill(Shape({2, 30}), 3.0);
+
+  auto x = AD("x", Shape({2, 30}));
+  auto y = AD("y", Shape({30, 2}));
+  auto z = AD("z", Shape({2, 30}));
+
+  // The chain is evaluated as one einsum, whatever order the tree has.
+  const auto expected =
+      multiply(multiply(a, {0, -1}, b, {-1, 1}), {0, -1}, c, {-1, 1});
+  const auto chain =
+      multiply(x, {0, -1}, multiply(y, {0, -1}, z, {-1, 1}), {-1, 1});
+  EXPECT_EQ(value(chain.evaluateAt({x = a, y = b, z = c})), expected);
+
+  // Partially evaluated chains keep the tree.
+  EXPECT_EQ(chain.evaluateAt({x = a, y = b}).expression().find("multiply"),
+            0ul);
+
+  // A chain whose cheapest pair would sum away every index.
+  auto u = AD("u", Shape({3}));
+  auto v = AD("v", Shape({2}));
+  auto w = AD("w", Shape({2}));
+  const auto outer = multiply(multiply(u, {0}, v, {1}), {0, -1}, w, {-1});
+  EXPECT_EQ(value(outer.evaluateAt({u = T({1.0, 2.0, 3.0}), v = T({1.0, 3.0}),
+                                    w = T({2.0, 3.0})})),
+            T({11.0, 22.0, 33.0}));
+}
+
+TEST(AD, StructuredJacobians) {
+  using T = Alexandria::Tensor<double>;
+  using AD = Alexandria::AD<T>;
+  using Alexandria::Shape;
+
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  const auto a = T::random(Shape({3, 4}), distribution);
+  const auto b = T::random(Shape({4, 2}), distribution);
+  auto x = AD("x", Shape({3, 4}));
+  auto y = AD("y", Shape({4, 2}));
+
+  // The Jacobian of an elementwise function is a diagonal.
+  const auto ds = value(sigmoid(x).differentiate(x).evaluateAt({x = a}));
+  ASSERT_TRUE(ds.isType<T::Diagonal>());
+  const auto s = 1.0 / (1.0 + std::exp(-a.at({1, 2})));
+  EXPECT_DOUBLE_EQ(ds.at({1, 2, 1, 2}), s * (1.0 - s));
+  EXPECT_EQ(ds.at({1, 2, 1, 3}), 0.0);
+
+  // The Jacobian of a matrix product is an identity times the other term,
+  // d(xy)_ik / dx_jl = delta_ij y_lk.
+  const auto dp = value(multiply(x, {0, -1}, y, {-1, 1})
+                            .differentiate(x)
+                            .evaluateAt({x = a, y = b}));
+  ASSERT_TRUE(dp.isType<T::Kronecker>());
+  EXPECT_EQ(dp.shape(), Shape({3, 2, 3, 4}));
+  EXPECT_DOUBLE_EQ(dp.at({1, 0, 1, 3}), b.at({3, 0}));
+  EXPECT_EQ(dp.at({1, 0, 2, 3}), 0.0);
+}
+
 int main(int argc, char** argv) {
   // Disables elapsed time by default.
   ::testing::GTEST_FLAG(print_time) = false;
@@ -0,0 +1,84 @@
+// Compares building, differentiating and simplifying a large scalar AD
+// expression with expression nodes allocated from the heap and from an Arena.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "automatic_differentiation/ad.h"
+#include "automatic_differentiation/ad_binary.h"
+#include "automatic_differentiation/ad_const.h"
+#include "automatic_differentiation/ad_param.h"
+#include "automatic_differentiation/ad_unary.h"
+#include "automatic_differentiation/ad_var.h"
+#include "util/arena.h"
+
+namespace {
+size_t n_heap_allocations = 0;
+}  // namespace
+
+// Count every call to the system allocator.
+void* operator new(size_t size) {
+  ++n_heap_allocations;
+  if (auto ptr = std::malloc(size)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace {
+using AD = Alexandria::AD<double>;
+
+// sum_i sin(c_i x) exp(y) + x / (i + 1)
+AD makeExpression(const AD& x, const AD& y, int n_terms) {
+  auto result = AD(0.0);
+  for (auto index = 0; index < n_terms; ++index) {
+    result = result + sin(AD(index * 0.1) * x) * exp(y) + x / AD(index + 1.0);
+  }
+  return result;
+}
+
+double run(AD x, AD y, int n_terms) {
+  auto expression = makeExpression(x, y, n_terms);
+  auto gradient = D(expression, x).simplify();
+  return value(gradient.evaluateAt({x = 0.5, y = 0.25}));
+}
+
+void report(const char* name, int n_terms, bool use_arena) {
+  const auto x = AD("x");
+  const auto y = AD("y");
+
+  const auto allocations_before = n_heap_allocations;
+  const auto start = std::chrono::steady_clock::now();
+
+  auto result = 0.0;
+  auto arena_allocations = 0ul;
+  if (use_arena) {
+    Alexandria::Arena arena;
+    result = run(x, y, n_terms);
+    arena_allocations = arena.nAllocations();
+  } else {
+    result = run(x, y, n_terms);
+  }
+
+  const auto stop = std::chrono::steady_clock::now();
+  const auto ms =
+      std::chrono::duration<double, std::milli>(stop - start).count();
+
+  std::cout << name << " terms=" << n_terms
+            << " heap_allocations=" << n_heap_allocations - allocations_before
+            << " arena_allocations=" << arena_allocations << " time_ms=" << ms
+            << " result=" << result << "\n";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto n_terms = argc > 1 ? std::atoi(argv[1]) : 200;
+
+  report("heap ", n_terms, false);
+  report("arena", n_terms, true);
+
+  return 0;
+}
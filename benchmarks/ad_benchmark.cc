@@ -0,0 +1,54 @@
+// Benchmarks of differentiating scalar AD expressions and evaluating the
+// derivatives.
+//
+// usage: ad_benchmark [--benchmark_format=json] [--benchmark_out=FILE]
+
+#include "automatic_differentiation/ad.h"
+#include "automatic_differentiation/ad_binary.h"
+#include "automatic_differentiation/ad_const.h"
+#include "automatic_differentiation/ad_param.h"
+#include "automatic_differentiation/ad_unary.h"
+#include "automatic_differentiation/ad_var.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+using AD = Alexandria::AD<double>;
+
+// sum_i sin(c_i x) exp(y) + x / (i + 1)
+AD makeExpression(const AD& x, const AD& y, int64_t n_terms) {
+  auto result = AD(0.0);
+  for (auto index = 0; index < n_terms; ++index) {
+    result = result + sin(AD(index * 0.1) * x) * exp(y) +
+             x / AD(index + 1.0);
+  }
+  return result;
+}
+
+void BM_DifferentiateScalar(benchmark::State& state) {
+  const auto x = AD("x");
+  const auto y = AD("y");
+  const auto expression = makeExpression(x, y, state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(D(expression, x).simplify());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DifferentiateScalar)->Arg(10)->Arg(30)->Arg(100);
+
+void BM_EvaluateScalarDerivative(benchmark::State& state) {
+  auto x = AD("x");
+  auto y = AD("y");
+  const auto gradient =
+      D(makeExpression(x, y, state.range(0)), x).simplify();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(value(gradient.evaluateAt({x = 0.5, y = 0.25})));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EvaluateScalarDerivative)->Arg(10)->Arg(30)->Arg(100);
+
+}  // namespace
+
+BENCHMARK_MAIN();
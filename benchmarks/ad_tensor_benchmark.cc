@@ -0,0 +1,38 @@
+// Benchmarks of differentiating tensor AD expressions and evaluating the
+// derivatives.
+//
+// usage: ad_tensor_benchmark [--benchmark_format=json] [--benchmark_out=FILE]
+
+#include "automatic_differentiation/ad_tensor.h"
+#include "benchmark/benchmark.h"
+#include "benchmarks/benchmark_tensors.h"
+
+namespace {
+using Alexandria::Shape;
+using Tensor = Alexandria::Tensor<double>;
+using AD = Alexandria::AD<Tensor>;
+namespace Benchmarks = Alexandria::Benchmarks;
+
+// Jacobian of the layer sigmoid(W x) with respect to x for an n x n W.
+void BM_DifferentiateTensor(benchmark::State& state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  auto w = AD("w", Shape({n, n}));
+  auto x = AD("x", Shape({n}));
+  const auto layer = sigmoid(multiply(w, {0, -1}, x, {-1}));
+  const auto w_value = Benchmarks::makeTensor<double>(
+      Shape({n, n}), Benchmarks::kDense, 100, 1);
+  const auto x_value =
+      Benchmarks::makeTensor<double>(Shape({n}), Benchmarks::kDense, 100, 2);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        value(D(layer, x).evaluateAt({w = w_value, x = x_value})));
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(n * n));
+}
+BENCHMARK(BM_DifferentiateTensor)->Arg(4)->Arg(8)->Arg(16);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,78 @@
+// Benchmarks of archiving tensors out to and in from memory streams over
+// sizes, sparsity and storage kinds.
+//
+// usage: archive_benchmark [--benchmark_format=json] [--benchmark_out=FILE]
+
+#include <sstream>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "benchmarks/benchmark_tensors.h"
+#include "tensor/tensor.h"
+#include "util/archive_in.h"
+#include "util/archive_out.h"
+
+namespace {
+using Alexandria::ArchiveIn;
+using Alexandria::ArchiveOut;
+using Alexandria::Shape;
+using Tensor = Alexandria::Tensor<double>;
+namespace Benchmarks = Alexandria::Benchmarks;
+
+// Arguments: number of elements, kind, density in percent.
+void archiveArguments(benchmark::internal::Benchmark* b) {
+  for (const auto n : {1 << 10, 1 << 16, 1 << 20}) {
+    b->Args({n, Benchmarks::kDense, 100});
+  }
+  for (const auto n : {1 << 10, 1 << 16}) {
+    b->Args({n, Benchmarks::kSparse, 1});
+    b->Args({n, Benchmarks::kSparse, 10});
+  }
+}
+
+std::string archive(const Tensor& t) {
+  std::ostringstream sout;
+  {
+    ArchiveOut ar(&sout);
+    ar % t;
+  }
+  return sout.str();
+}
+
+void BM_ArchiveOut(benchmark::State& state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  const auto t = Benchmarks::makeTensor<double>(Shape({n}), state.range(1),
+                                                state.range(2));
+
+  auto n_bytes = 0ul;
+  for (auto _ : state) {
+    const auto bytes = archive(t);
+    n_bytes = bytes.size();
+    benchmark::DoNotOptimize(bytes.data());
+  }
+  state.SetLabel(Benchmarks::storageName(state.range(1)));
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n_bytes));
+}
+BENCHMARK(BM_ArchiveOut)->Apply(archiveArguments);
+
+void BM_ArchiveIn(benchmark::State& state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  const auto bytes = archive(Benchmarks::makeTensor<double>(
+      Shape({n}), state.range(1), state.range(2)));
+
+  for (auto _ : state) {
+    std::istringstream sin(bytes);
+    ArchiveIn ar(&sin);
+    Tensor t;
+    ar % t;
+    benchmark::DoNotOptimize(t);
+  }
+  state.SetLabel(Benchmarks::storageName(state.range(1)));
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(bytes.size()));
+}
+BENCHMARK(BM_ArchiveIn)->Apply(archiveArguments);
+
+}  // namespace
+
+BENCHMARK_MAIN();
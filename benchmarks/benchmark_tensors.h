@@ -0,0 +1,61 @@
+#ifndef BENCHMARKS_BENCHMARK_TENSORS_H_
+#define BENCHMARKS_BENCHMARK_TENSORS_H_
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "tensor/tensor.h"
+
+namespace Alexandria {
+namespace Benchmarks {
+
+// Storage kinds benchmarks are parameterized over, passed as integer
+// arguments.
+enum StorageKind : int64_t {
+  kDense = 0,
+  kSparse = 1,
+  kConstDiagonal = 2,
+};
+
+inline std::string storageName(int64_t kind) {
+  switch (kind) {
+    case kDense:
+      return "dense";
+    case kSparse:
+      return "sparse";
+    case kConstDiagonal:
+      return "const_diagonal";
+  }
+  return "unknown";
+}
+
+// Tensor of shape and kind with uniform(-1, 1) values.  Sparse tensors keep
+// about density percent of the elements.  The values only depend on seed.
+template <typename T>
+Tensor<T> makeTensor(const Shape& shape, int64_t kind, int64_t density,
+                     uint32_t seed = 1) {
+  if (kind == kConstDiagonal) return Tensor<T>::constDiagonal(shape);
+
+  std::mt19937 engine(seed);
+  std::uniform_real_distribution<T> distribution(-1, 1);
+  std::uniform_int_distribution<int64_t> percent(0, 99);
+  auto result =
+      kind == kDense ? Tensor<T>::dense(shape) : Tensor<T>::sparse(shape);
+
+  Address address(shape.nDimensions(), 0ul);
+  const auto size = nElements(shape);
+  for (auto index = 0ul; index < size; ++index) {
+    const auto value = distribution(engine);
+    if (kind == kDense || percent(engine) < density) {
+      result.set(address, value);
+    }
+    advance(&address, shape);
+  }
+  return result;
+}
+
+}  // namespace Benchmarks
+}  // namespace Alexandria
+
+#endif  // BENCHMARKS_BENCHMARK_TENSORS_H_
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Compare benchmark results against a saved baseline.
+
+Both files are the JSON written by the benchmark executables with
+--benchmark_out=FILE (or --benchmark_format=json).  Benchmarks are matched by
+name and compared on real time per iteration; aggregates, when the runs were
+repeated, are compared on their median.
+
+usage: compare.py [--threshold PERCENT] baseline.json current.json
+
+Exits with status 1 if any benchmark is slower than the baseline by more than
+the threshold.
+"""
+
+import argparse
+import json
+import sys
+
+# Time units as written by Google Benchmark, in nanoseconds.
+UNITS = {'ns': 1.0, 'us': 1E3, 'ms': 1E6, 's': 1E9}
+
+
+def load(path):
+    """Real time in nanoseconds per benchmark name."""
+    with open(path) as f:
+        results = json.load(f)
+
+    times = {}
+    medians = {}
+    for benchmark in results['benchmarks']:
+        time = benchmark['real_time'] * UNITS[benchmark.get('time_unit', 'ns')]
+        if benchmark.get('run_type') == 'aggregate':
+            if benchmark.get('aggregate_name') == 'median':
+                medians[benchmark['run_name']] = time
+        elif benchmark.get('error_occurred'):
+            continue
+        else:
+            # Repetitions are only compared through their median.
+            times.setdefault(benchmark['name'], time)
+    times.update(medians)
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='slowdown in percent that fails (default 10)')
+    parser.add_argument('baseline')
+    parser.add_argument('current')
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    slower = []
+    width = max([len(name) for name in list(current) + list(baseline)] + [14])
+    print('%-*s %12s %12s %8s' % (width, 'benchmark (ns)', 'baseline',
+                                  'current', 'change'))
+    for name in current:
+        if name not in baseline:
+            print('%-*s %12s %12.0f %8s' % (width, name, '-', current[name],
+                                            'new'))
+            continue
+        change = 100.0 * (current[name] / baseline[name] - 1.0)
+        flag = ''
+        if change > args.threshold:
+            slower.append(name)
+            flag = ' SLOWER'
+        print('%-*s %12.0f %12.0f %+7.1f%%%s' % (width, name, baseline[name],
+                                                 current[name], change, flag))
+    for name in sorted(set(baseline) - set(current)):
+        print('%-*s %12.0f %12s %8s' % (width, name, baseline[name], '-',
+                                        'missing'))
+
+    if slower:
+        print('\n%d of %d benchmarks slower than the baseline by more than '
+              '%g%%' % (len(slower), len(current), args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
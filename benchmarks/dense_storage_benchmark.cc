@@ -0,0 +1,66 @@
+// Times large Dense tensor kernels with buffers on normal pages and advised
+// to use transparent huge pages.
+//
+// usage: dense_storage_benchmark [matrix_size] [n_elements]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "tensor/tensor.h"
+#include "util/buffer_pool.h"
+
+namespace {
+using Alexandria::BufferPool;
+using Alexandria::bufferPool;
+using Alexandria::Shape;
+using Tensor = Alexandria::Tensor<double>;
+
+template <typename TFn>
+double timeMs(TFn fn) {
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  const auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+void report(const char* name, size_t matrix_size, size_t n_elements,
+            size_t huge_page_threshold) {
+  // Drop cached buffers so the new backing takes effect.
+  bufferPool().clear();
+  bufferPool().setHugePageThreshold(huge_page_threshold);
+  bufferPool().resetStatistics();
+
+  const auto matrix = Tensor::random(Shape({matrix_size, matrix_size}));
+  const auto vector = Tensor::random(Shape({matrix_size}));
+  auto contraction = 0.0;
+  const auto contraction_ms = timeMs([&]() {
+    contraction = multiply(matrix, {0, -1}, vector, {-1}).at({0});
+  });
+
+  const auto large = Tensor::random(Shape({n_elements}));
+  auto sum = 0.0;
+  const auto elementwise_ms = timeMs([&]() {
+    for (auto iteration = 0; iteration < 10; ++iteration) {
+      const auto result = large + large * 0.5;
+      sum += result.at({n_elements - 1});
+    }
+  });
+
+  std::cout << name << " contraction_ms=" << contraction_ms
+            << " elementwise_ms=" << elementwise_ms
+            << " huge_pages=" << bufferPool().statistics().huge_pages
+            << " result=" << contraction + sum << "\n";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto matrix_size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+  const auto n_elements =
+      argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8ul << 20;
+
+  report("normal", matrix_size, n_elements, 0ul);
+  report("huge  ", matrix_size, n_elements, BufferPool::kHugePageSize);
+
+  return 0;
+}
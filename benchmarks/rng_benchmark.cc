@@ -0,0 +1,53 @@
+// Compares drawing uniform and normal variates one at a time through the
+// standard distributions with the bulk samplers, for a 784x500 weight matrix.
+//
+// usage: rng_benchmark [n_values]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "util/philox.h"
+#include "util/samplers.h"
+
+namespace {
+using Alexandria::Philox;
+namespace Samplers = Alexandria::Samplers;
+
+template <typename TFn>
+void report(const char* name, std::vector<double>* values, TFn fn) {
+  const auto start = std::chrono::steady_clock::now();
+  for (auto iteration = 0; iteration < 10; ++iteration) fn(values);
+  const auto stop = std::chrono::steady_clock::now();
+  const auto ms =
+      std::chrono::duration<double, std::milli>(stop - start).count() / 10;
+
+  std::cout << name << " n=" << values->size() << " time_ms=" << ms
+            << " last=" << values->back() << "\n";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 784ul * 500;
+  std::vector<double> values(n);
+
+  Philox engine(1);
+  report("uniform scalar", &values, [&](std::vector<double>* out) {
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    for (auto& value : *out) value = distribution(engine);
+  });
+  report("uniform bulk  ", &values, [&](std::vector<double>* out) {
+    Samplers::uniform(engine, -1.0, 1.0, out->data(), out->data() + n);
+  });
+  report("normal scalar ", &values, [&](std::vector<double>* out) {
+    std::normal_distribution<double> distribution;
+    for (auto& value : *out) value = distribution(engine);
+  });
+  report("normal bulk   ", &values, [&](std::vector<double>* out) {
+    Samplers::normal(engine, 0.0, 1.0, out->data(), out->data() + n);
+  });
+
+  return 0;
+}
@@ -0,0 +1,195 @@
+// Benchmarks of the tensor kernels: multiply, apply and address increment over
+// shapes, sparsity and storage kinds, fixed shape multiply, einsum and
+// structured Jacobians.
+//
+// usage: tensor_benchmark [--benchmark_format=json] [--benchmark_out=FILE]
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "benchmarks/benchmark_tensors.h"
+#include "tensor/einsum.h"
+#include "tensor/fixed_tensor.h"
+#include "tensor/tensor.h"
+
+namespace {
+using Alexandria::Address;
+using Alexandria::EinsumPlan;
+using Alexandria::FixedTensor;
+using Alexandria::Odometer;
+using Alexandria::Shape;
+using Tensor = Alexandria::Tensor<double>;
+namespace Benchmarks = Alexandria::Benchmarks;
+
+// Arguments: n, kind of S, kind of T, density of sparse operands in percent.
+void multiplyArguments(benchmark::internal::Benchmark* b) {
+  for (const auto n : {8, 16, 32}) {
+    for (const auto kind1 : {Benchmarks::kDense, Benchmarks::kSparse}) {
+      for (const auto kind2 : {Benchmarks::kDense, Benchmarks::kSparse}) {
+        const auto sparse =
+            kind1 == Benchmarks::kSparse || kind2 == Benchmarks::kSparse;
+        for (const auto density : {10, 100}) {
+          if (!sparse && density != 100) continue;
+          // Full sparse operands of 32 x 32 take seconds per multiply.
+          if (sparse && density == 100 && n > 16) continue;
+          b->Args({n, kind1, kind2, density});
+        }
+      }
+    }
+  }
+}
+
+// Matrix multiply R_ik = Sum_j S_ij T_jk of n x n matrices.
+void BM_Multiply(benchmark::State& state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  const auto shape = Shape({n, n});
+  const auto t1 = Benchmarks::makeTensor<double>(shape, state.range(1),
+                                                 state.range(3), 1);
+  const auto t2 = Benchmarks::makeTensor<double>(shape, state.range(2),
+                                                 state.range(3), 2);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(multiply(t1, {0, -1}, t2, {-1, 1}));
+  }
+  state.SetLabel(Benchmarks::storageName(state.range(1)) + "x" +
+                 Benchmarks::storageName(state.range(2)));
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(n * n * n));
+}
+BENCHMARK(BM_Multiply)->Apply(multiplyArguments);
+
+// Arguments: number of elements, kind, density in percent.
+void applyArguments(benchmark::internal::Benchmark* b) {
+  for (const auto n : {1 << 10, 1 << 14}) {
+    b->Args({n, Benchmarks::kDense, 100});
+    b->Args({n, Benchmarks::kSparse, 10});
+    b->Args({n, Benchmarks::kSparse, 100});
+  }
+  b->Args({1 << 20, Benchmarks::kDense, 100});
+}
+
+void BM_Apply(benchmark::State& state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  const auto t = Benchmarks::makeTensor<double>(Shape({n}), state.range(1),
+                                                state.range(2));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        Alexandria::apply<double>(t, [](double x) { return 2 * x + 1; }));
+  }
+  state.SetLabel(Benchmarks::storageName(state.range(1)));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Apply)->Apply(applyArguments);
+
+void BM_ApplyBinary(benchmark::State& state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  const auto t1 = Benchmarks::makeTensor<double>(Shape({n}), state.range(1),
+                                                 state.range(2), 1);
+  const auto t2 = Benchmarks::makeTensor<double>(Shape({n}), state.range(1),
+                                                 state.range(2), 2);
+
+  for (auto _ : state) benchmark::DoNotOptimize(plus(t1, t2));
+  state.SetLabel(Benchmarks::storageName(state.range(1)));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ApplyBinary)->Apply(applyArguments);
+
+// Walk every address of a shape of 2^16 elements with range(0) dimensions.
+void BM_Increment(benchmark::State& state) {
+  const auto n_dimensions = static_cast<size_t>(state.range(0));
+  const auto extent = static_cast<size_t>(1) << (16 / n_dimensions);
+  const auto shape = Shape(std::vector<size_t>(n_dimensions, extent));
+  const auto size = nElements(shape);
+
+  for (auto _ : state) {
+    Address address(n_dimensions, 0ul);
+    for (auto index = 0ul; index < size; ++index) {
+      address = increment(std::move(address), shape);
+    }
+    benchmark::DoNotOptimize(address);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size));
+}
+BENCHMARK(BM_Increment)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+// The same walk with an Odometer, also tracking the flat offset.
+void BM_Odometer(benchmark::State& state) {
+  const auto n_dimensions = static_cast<size_t>(state.range(0));
+  const auto extent = static_cast<size_t>(1) << (16 / n_dimensions);
+  const auto shape = Shape(std::vector<size_t>(n_dimensions, extent));
+  const auto size = nElements(shape);
+
+  for (auto _ : state) {
+    auto sum = 0ul;
+    for (Odometer odometer(shape); !odometer.done(); odometer.next()) {
+      sum += odometer.offset();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size));
+}
+BENCHMARK(BM_Odometer)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+// 3 x 3 matrix multiply with fixed shapes, to compare with BM_Multiply.
+void BM_FixedMultiply(benchmark::State& state) {
+  const auto t1 = FixedTensor<double, 3, 3>(Tensor::fill(Shape({3, 3}), 1.0));
+  const auto t2 = FixedTensor<double, 3, 3>(Tensor::fill(Shape({3, 3}), 2.0));
+
+  for (auto _ : state) benchmark::DoNotOptimize(multiply(t1, t2));
+  state.SetItemsProcessed(state.iterations() * 27);
+}
+BENCHMARK(BM_FixedMultiply);
+
+// R_il = Sum_jk A_ij B_jk C_kl of 4 x n, n x 4 and 4 x n matrices, in the
+// order of the expression tree A (B C) (argument 0) or planned (argument 1).
+void BM_Einsum(benchmark::State& state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  const auto a = Tensor::fill(Shape({4, n}), 1.0);
+  const auto b = Tensor::fill(Shape({n, 4}), 2.0);
+  const auto c = Tensor::fill(Shape({4, n}), 3.0);
+
+  for (auto _ : state) {
+    if (state.range(1) == 0) {
+      benchmark::DoNotOptimize(
+          multiply(a, {0, -1}, multiply(b, {0, -1}, c, {-1, 1}), {-1, 1}));
+    } else {
+      benchmark::DoNotOptimize(Alexandria::einsum<double>(
+          {&a, &b, &c}, {{0, -1}, {-1, -2}, {-2, 1}}, EinsumPlan::kAuto));
+    }
+  }
+  state.SetLabel(state.range(1) == 0 ? "tree" : "planned");
+}
+BENCHMARK(BM_Einsum)
+    ->Args({16, 0})
+    ->Args({16, 1})
+    ->Args({64, 0})
+    ->Args({64, 1});
+
+// Chain rule contraction R_ik,m = Sum_jl E_ik,jl X_jl,m of an identity E of
+// n x n matrices with a dense X of n x n x 4, with E as an identity (argument
+// 1) or as its stored elements (argument 0).
+void BM_IdentityChainRule(benchmark::State& state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  const auto identity = Tensor::sparseEye(Shape({n, n, n, n}));
+  auto eye = Tensor::sparse(identity.shape());
+  for (const auto& address_value : identity) {
+    eye.set(address_value.first, address_value.second);
+  }
+  const auto& e = state.range(1) == 0 ? eye : identity;
+  const auto x = Tensor::fill(Shape({n, n, 4}), 1.0);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(multiply(e, {0, 1, -1, -2}, x, {-1, -2, 2}));
+  }
+  state.SetLabel(state.range(1) == 0 ? "elements" : "identity");
+}
+BENCHMARK(BM_IdentityChainRule)
+    ->Args({8, 0})
+    ->Args({8, 1})
+    ->Args({16, 0})
+    ->Args({16, 1});
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -94,6 +94,7 @@ int main() {
   ofstream fout("mnist_training.alx");
   ArchiveOut ar(&fout);
   ar % labels % data;
+  ar.flush();
   fout.close();
 
   return 0;
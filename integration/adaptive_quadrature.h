@@ -0,0 +1,287 @@
+#ifndef INTEGRATION_ADAPTIVE_QUADRATURE_H_
+#define INTEGRATION_ADAPTIVE_QUADRATURE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#include "integration/quadrature.h"
+#include "util/util.h"
+
+namespace Alexandria {
+
+// Adaptive Gauss-Kronrod integration.
+//
+// Each interval is integrated with a Kronrod rule and the Gauss rule embedded
+// in it; their difference estimates the error as in QUADPACK.  The interval
+// with the largest error is bisected until the total error is within
+// tolerance, so evaluations are spent only where the integrand needs them.
+template <typename T>
+class AdaptiveQuadrature {
+ public:
+  using BatchFunction = typename Quadrature<T>::BatchFunction;
+  // Positive Kronrod abscissas on (-1, 1), decreasing, ending with 0.
+  using Abscissas = std::vector<T>;
+  using Weights = std::vector<T>;
+
+  struct Result {
+    T value;
+    // Estimate of the absolute error.
+    T error;
+    size_t n_evaluations;
+    size_t n_intervals;
+    // Whether the error is within tolerance.
+    bool converged;
+  };
+
+  // kronrodWeights match kronrodAbscissas.  The Gauss abscissas are every other
+  // Kronrod one from the second, and 0 when that falls on the center;
+  // gaussWeights are their weights in that order.
+  AdaptiveQuadrature(T absolute_tolerance, T relative_tolerance,
+                     size_t max_intervals, const Abscissas& kronrodAbscissas,
+                     const Weights& kronrodWeights, const Weights& gaussWeights)
+      : absolute_tolerance_(absolute_tolerance),
+        relative_tolerance_(relative_tolerance),
+        max_intervals_(max_intervals),
+        kronrodAbscissas_(kronrodAbscissas),
+        kronrodWeights_(kronrodWeights),
+        gaussWeights_(gaussWeights) {
+    CHECK(max_intervals_ > 0) << "max_intervals == 0";
+    CHECK(kronrodAbscissas_.size() == kronrodWeights_.size())
+        << "abscissas and weights differ in size";
+    CHECK(gaussWeights_.size() == kronrodAbscissas_.size() / 2)
+        << "wrong number of gauss weights";
+  }
+  virtual ~AdaptiveQuadrature() {}
+
+  // Integrates the function f between x_min and x_max.
+  Result operator()(const std::function<T(T)>& f, T x_min, T x_max) const {
+    return (*this)(
+        [&f](const T* xs, T* ys, size_t n) {
+          std::transform(xs, xs + n, ys, f);
+        },
+        x_min, x_max);
+  }
+
+  // Integrates f evaluating the points of two sibling intervals per call.
+  Result operator()(const BatchFunction& f, T x_min, T x_max) const;
+
+  // Points evaluated per interval.
+  size_t nPoints() const { return 2 * kronrodAbscissas_.size() - 1; }
+
+ private:
+  struct Interval {
+    T x_min;
+    T x_max;
+    T value;
+    T error;
+
+    bool operator<(const Interval& interval) const {
+      return error < interval.error;
+    }
+  };
+
+  // Points of [x_min, x_max] in the order estimate expects them.
+  void points(T x_min, T x_max, T* xs) const;
+
+  // Integrate [x_min, x_max] from the values at its points.
+  Interval estimate(T x_min, T x_max, const T* ys) const;
+
+  T absolute_tolerance_;
+  T relative_tolerance_;
+  size_t max_intervals_;
+  Abscissas kronrodAbscissas_;
+  Weights kronrodWeights_;
+  Weights gaussWeights_;
+};
+
+template <typename T>
+void AdaptiveQuadrature<T>::points(T x_min, T x_max, T* xs) const {
+  const auto center = (x_min + x_max) / 2;
+  const auto half_length = (x_max - x_min) / 2;
+  const auto n = kronrodAbscissas_.size();
+  for (auto index = 0ul; index + 1 < n; ++index) {
+    xs[2 * index] = center - half_length * kronrodAbscissas_[index];
+    xs[2 * index + 1] = center + half_length * kronrodAbscissas_[index];
+  }
+  xs[2 * n - 2] = center;
+}
+
+template <typename T>
+auto AdaptiveQuadrature<T>::estimate(T x_min, T x_max, const T* ys) const
+    -> Interval {
+  const auto half_length = (x_max - x_min) / 2;
+  const auto n = kronrodAbscissas_.size();
+  const auto y_center = ys[2 * n - 2];
+
+  auto kronrod = kronrodWeights_[n - 1] * y_center;
+  auto gauss = n % 2 == 0 ? gaussWeights_[n / 2 - 1] * y_center : T(0);
+  auto absolute = std::abs(kronrod);
+  for (auto index = 0ul; index + 1 < n; ++index) {
+    const auto sum = ys[2 * index] + ys[2 * index + 1];
+    kronrod += kronrodWeights_[index] * sum;
+    absolute += kronrodWeights_[index] *
+                (std::abs(ys[2 * index]) + std::abs(ys[2 * index + 1]));
+    if (index % 2 == 1) gauss += gaussWeights_[index / 2] * sum;
+  }
+
+  // Integral of |f - mean| to scale the error as QUADPACK does.
+  const auto mean = kronrod / 2;
+  auto deviation = kronrodWeights_[n - 1] * std::abs(y_center - mean);
+  for (auto index = 0ul; index + 1 < n; ++index) {
+    deviation +=
+        kronrodWeights_[index] *
+        (std::abs(ys[2 * index] - mean) + std::abs(ys[2 * index + 1] - mean));
+  }
+
+  const auto epsilon = std::numeric_limits<T>::epsilon();
+  auto error = std::abs((kronrod - gauss) * half_length);
+  deviation *= std::abs(half_length);
+  absolute *= std::abs(half_length);
+  if (deviation != 0 && error != 0) {
+    error = deviation * std::min(T(1), std::pow(200 * error / deviation, 1.5));
+  }
+  if (absolute > std::numeric_limits<T>::min() / (50 * epsilon)) {
+    error = std::max(50 * epsilon * absolute, error);
+  }
+
+  return {x_min, x_max, kronrod * half_length, error};
+}
+
+template <typename T>
+auto AdaptiveQuadrature<T>::operator()(const BatchFunction& f, T x_min,
+                                       T x_max) const -> Result {
+  CHECK(x_min < x_max) << "x_min >= x_max";
+
+  const auto n_points = nPoints();
+  std::vector<T> xs(2 * n_points);
+  std::vector<T> ys(2 * n_points);
+
+  points(x_min, x_max, xs.data());
+  f(xs.data(), ys.data(), n_points);
+  auto n_evaluations = n_points;
+
+  std::priority_queue<Interval> intervals;
+  intervals.push(estimate(x_min, x_max, ys.data()));
+  auto value = intervals.top().value;
+  auto error = intervals.top().error;
+
+  auto within_tolerance = [&]() {
+    return error <=
+           std::max(absolute_tolerance_, relative_tolerance_ * std::abs(value));
+  };
+
+  while (!within_tolerance() && intervals.size() < max_intervals_) {
+    const auto worst = intervals.top();
+    const auto middle = (worst.x_min + worst.x_max) / 2;
+    // Stop once the interval cannot be split any further.
+    if (!(worst.x_min < middle && middle < worst.x_max)) break;
+    intervals.pop();
+
+    points(worst.x_min, middle, xs.data());
+    points(middle, worst.x_max, xs.data() + n_points);
+    f(xs.data(), ys.data(), 2 * n_points);
+    n_evaluations += 2 * n_points;
+
+    const auto left = estimate(worst.x_min, middle, ys.data());
+    const auto right = estimate(middle, worst.x_max, ys.data() + n_points);
+    value += left.value + right.value - worst.value;
+    error += left.error + right.error - worst.error;
+    intervals.push(left);
+    intervals.push(right);
+  }
+
+  // Sum again from left to right so the result does not depend on the update
+  // order above.
+  std::vector<Interval> sorted;
+  sorted.reserve(intervals.size());
+  for (; !intervals.empty(); intervals.pop()) {
+    sorted.emplace_back(intervals.top());
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const Interval& x, const Interval& y) {
+              return x.x_min < y.x_min;
+            });
+  value = T(0);
+  error = T(0);
+  for (const auto& interval : sorted) {
+    value += interval.value;
+    error += interval.error;
+  }
+
+  return {value, error, n_evaluations, sorted.size(), within_tolerance()};
+}
+
+// 7 point Gauss and 15 point Kronrod rules.
+template <typename T>
+class GaussKronrod15 : public AdaptiveQuadrature<T> {
+ public:
+  explicit GaussKronrod15(T absolute_tolerance = 1E-10,
+                          T relative_tolerance = 1E-10,
+                          size_t max_intervals = 1000)
+      : AdaptiveQuadrature<T>(
+            absolute_tolerance, relative_tolerance, max_intervals,
+            {0.991455371120812639206854697526329,
+             0.949107912342758524526189684047851,
+             0.864864423359769072789712788640926,
+             0.741531185599394439863864773280788,
+             0.586087235467691130294144845693013,
+             0.405845151377397166906606412076961,
+             0.207784955007898467600689403773245, 0.0},
+            {0.022935322010529224963732008058970,
+             0.063092092629978553290700663189204,
+             0.104790010322250183839876322541518,
+             0.140653259715525918745189590510238,
+             0.169004726639267902826583426598550,
+             0.190350578064785409913256402421014,
+             0.204432940075298892414161999234649,
+             0.209482141084727828012999174891714},
+            {0.129484966168869693270611432679082,
+             0.279705391489276667901467771423780,
+             0.381830050505118944950369775488975,
+             0.417959183673469387755102040816327}) {}
+};
+
+// 10 point Gauss and 21 point Kronrod rules.
+template <typename T>
+class GaussKronrod21 : public AdaptiveQuadrature<T> {
+ public:
+  explicit GaussKronrod21(T absolute_tolerance = 1E-10,
+                          T relative_tolerance = 1E-10,
+                          size_t max_intervals = 1000)
+      : AdaptiveQuadrature<T>(
+            absolute_tolerance, relative_tolerance, max_intervals,
+            {0.995657163025808080735527280689003,
+             0.973906528517171720077964012084452,
+             0.930157491355708226001207180059508,
+             0.865063366688984510732096688423493,
+             0.780817726586416897063717578345042,
+             0.679409568299024406234327365114874,
+             0.562757134668604683339000099272694,
+             0.433395394129247190799265943165784,
+             0.294392862701460198131126603103866,
+             0.148874338981631210884826001129720, 0.0},
+            {0.011694638867371874278064396062192,
+             0.032558162307964727478818972459390,
+             0.054755896574351996031381300244580,
+             0.075039674810919952767043140916190,
+             0.093125454583697605535065465083366,
+             0.109387158802297641899210590325805,
+             0.123491976262065851077600525160336,
+             0.134709217311473325928054001771707,
+             0.142775938577060080797094273138717,
+             0.147739104901338491374841515972068,
+             0.149445554002916905664936468389821},
+            {0.066671344308688137593568809893332,
+             0.149451349150580593145776339657697,
+             0.219086362515982043995534934228163,
+             0.269266719309996355091226921569469,
+             0.295524224714752870173892994651338}) {}
+};
+
+}  // namespace Alexandria
+
+#endif  // INTEGRATION_ADAPTIVE_QUADRATURE_H_
@@ -0,0 +1,330 @@
+#ifndef INTEGRATION_MULTIDIMENSIONAL_QUADRATURE_H_
+#define INTEGRATION_MULTIDIMENSIONAL_QUADRATURE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "integration/quadrature.h"
+#include "util/util.h"
+
+namespace Alexandria {
+
+// Integration over boxes in several dimensions from a one dimensional rule.
+//
+// Level l of the rule is the rule with 2^(l - 1) units.  A tensor product grid
+// of level l uses level l in every dimension, so it costs the number of nodes
+// to the power of the dimension.  A Smolyak sparse grid of level l combines
+// the tensor products of lower levels whose levels sum to at most
+// l + dimension - 1 (the combination technique), keeping most of the accuracy
+// for smooth integrands at a fraction of the points.  Points shared by several
+// of the combined grids, as with the nested levels of Simpson and Gauss-Lobatto
+// rules, are merged and evaluated once.
+//
+// Points are evaluated on n_threads threads in chunks of kChunkSize.  Each
+// chunk is summed in order into its own partial sum and the partial sums are
+// added in chunk order, so the result does not depend on the number of
+// threads or their scheduling.  The function must be safe to call from
+// several threads.
+template <typename T>
+class MultidimensionalQuadrature {
+ public:
+  using Point = std::vector<T>;
+  using Function = std::function<T(const Point&)>;
+  // Makes the one dimensional rule with nUnits units.
+  using Rule = std::function<std::unique_ptr<Quadrature<T>>(size_t nUnits)>;
+
+  enum class Grid { kTensorProduct, kSmolyak };
+
+  // Points per chunk.
+  static constexpr size_t kChunkSize = 1024;
+
+  // n_threads of 0 uses the hardware concurrency.
+  MultidimensionalQuadrature(Rule rule, Grid grid, size_t level,
+                             size_t n_threads = 0)
+      : rule_(std::move(rule)), grid_(grid), level_(level) {
+    CHECK(level_ > 0) << "level == 0";
+    n_threads_ = n_threads > 0
+                     ? n_threads
+                     : std::max(1u, std::thread::hardware_concurrency());
+  }
+  virtual ~MultidimensionalQuadrature() {}
+
+  // Integrates f over the box [lower[i], upper[i]] for each dimension i.
+  T operator()(const Function& f, const Point& lower, const Point& upper) const;
+
+  // Number of function evaluations in n_dimensions.
+  size_t nPoints(size_t n_dimensions) const;
+
+  size_t nThreads() const { return n_threads_; }
+
+ private:
+  // A tensor product of one dimensional rules.
+  struct TensorGrid {
+    std::vector<typename Quadrature<T>::Values> xs;
+    std::vector<typename Quadrature<T>::Weights> weights;
+    size_t size;
+  };
+
+  // Levels of the grids combined in n_dimensions, with their coefficients.
+  void combination(size_t n_dimensions,
+                   std::vector<std::vector<size_t>>* levels,
+                   std::vector<T>* coefficients) const;
+
+  // The grids combined on the box, with their coefficients.
+  void grids(const Point& lower, const Point& upper,
+             std::vector<TensorGrid>* grids,
+             std::vector<T>* coefficients) const;
+
+  // The distinct points of the sparse grid on the box with their combined
+  // weights, in lexicographic order.
+  void sparsePoints(const Point& lower, const Point& upper,
+                    std::vector<Point>* points, std::vector<T>* weights) const;
+
+  // Call visit(x, weight) for points [begin, end) of grid.  The last dimension
+  // varies fastest.
+  template <typename TVisit>
+  static void forEachPoint(const TensorGrid& grid, size_t begin, size_t end,
+                           TVisit visit);
+
+  // Sum sum(begin, end) over the chunks of n_points on the threads, adding the
+  // partial sums in chunk order.
+  T reduce(size_t n_points,
+           const std::function<T(size_t, size_t)>& sum) const;
+
+  Rule rule_;
+  Grid grid_;
+  size_t level_;
+  size_t n_threads_;
+};
+
+template <typename T>
+constexpr size_t MultidimensionalQuadrature<T>::kChunkSize;
+
+template <typename T>
+void MultidimensionalQuadrature<T>::combination(
+    size_t n_dimensions, std::vector<std::vector<size_t>>* levels,
+    std::vector<T>* coefficients) const {
+  levels->clear();
+  coefficients->clear();
+  if (grid_ == Grid::kTensorProduct) {
+    levels->emplace_back(n_dimensions, level_);
+    coefficients->emplace_back(T(1));
+    return;
+  }
+
+  // Levels l_i >= 1 with q - d < |l| <= q for q = level + d - 1, weighted by
+  // (-1)^(q - |l|) binomial(d - 1, q - |l|).  Enumerated in lexicographic
+  // order.
+  const auto q = level_ + n_dimensions - 1;
+  std::vector<size_t> current(n_dimensions, 1);
+  auto total = n_dimensions;
+  while (true) {
+    if (total + n_dimensions > q) {
+      const auto k = q - total;
+      auto binomial = 1.0;
+      for (auto index = 0ul; index < k; ++index) {
+        binomial = binomial * (n_dimensions - 1 - index) / (index + 1);
+      }
+      levels->emplace_back(current);
+      coefficients->emplace_back(static_cast<T>(k % 2 == 0 ? binomial
+                                                           : -binomial));
+    }
+
+    // Next multi-index with |l| <= q, the last dimension fastest.
+    auto advanced = false;
+    for (auto dimension = n_dimensions; dimension > 0 && !advanced;
+         --dimension) {
+      if (total < q) {
+        ++current[dimension - 1];
+        ++total;
+        advanced = true;
+      } else {
+        total -= current[dimension - 1] - 1;
+        current[dimension - 1] = 1;
+      }
+    }
+    if (!advanced) break;
+  }
+}
+
+template <typename T>
+void MultidimensionalQuadrature<T>::grids(
+    const Point& lower, const Point& upper, std::vector<TensorGrid>* grids,
+    std::vector<T>* coefficients) const {
+  const auto n_dimensions = lower.size();
+  std::vector<std::vector<size_t>> levels;
+  combination(n_dimensions, &levels, coefficients);
+
+  grids->resize(levels.size());
+  for (auto index = 0ul; index < levels.size(); ++index) {
+    auto& grid = (*grids)[index];
+    grid.xs.resize(n_dimensions);
+    grid.weights.resize(n_dimensions);
+    grid.size = 1;
+    for (auto dimension = 0ul; dimension < n_dimensions; ++dimension) {
+      const auto rule = rule_(1ul << (levels[index][dimension] - 1));
+      rule->nodes(lower[dimension], upper[dimension], &grid.xs[dimension],
+                  &grid.weights[dimension]);
+      grid.size *= grid.xs[dimension].size();
+    }
+  }
+}
+
+template <typename T>
+void MultidimensionalQuadrature<T>::sparsePoints(
+    const Point& lower, const Point& upper, std::vector<Point>* points,
+    std::vector<T>* weights) const {
+  std::vector<TensorGrid> grids;
+  std::vector<T> coefficients;
+  this->grids(lower, upper, &grids, &coefficients);
+
+  // Ordered, so that the points are summed in the same order every time.
+  std::map<Point, T> merged;
+  for (auto index = 0ul; index < grids.size(); ++index) {
+    const auto& grid = grids[index];
+    forEachPoint(grid, 0, grid.size, [&](const Point& x, T weight) {
+      merged[x] += coefficients[index] * weight;
+    });
+  }
+
+  points->clear();
+  weights->clear();
+  for (const auto& entry : merged) {
+    // Weights cancelled out by the combination need no evaluation.
+    if (entry.second == T(0)) continue;
+    points->emplace_back(entry.first);
+    weights->emplace_back(entry.second);
+  }
+}
+
+template <typename T>
+template <typename TVisit>
+void MultidimensionalQuadrature<T>::forEachPoint(const TensorGrid& grid,
+                                                 size_t begin, size_t end,
+                                                 TVisit visit) {
+  const auto n_dimensions = grid.xs.size();
+
+  // Odometer over the node indices, starting at point begin.
+  std::vector<size_t> indices(n_dimensions);
+  auto rest = begin;
+  for (auto dimension = n_dimensions; dimension > 0; --dimension) {
+    const auto n = grid.xs[dimension - 1].size();
+    indices[dimension - 1] = rest % n;
+    rest /= n;
+  }
+
+  Point x(n_dimensions);
+  for (auto point = begin; point < end; ++point) {
+    auto weight = T(1);
+    for (auto dimension = 0ul; dimension < n_dimensions; ++dimension) {
+      x[dimension] = grid.xs[dimension][indices[dimension]];
+      weight *= grid.weights[dimension][indices[dimension]];
+    }
+    visit(x, weight);
+
+    for (auto dimension = n_dimensions; dimension > 0; --dimension) {
+      if (++indices[dimension - 1] < grid.xs[dimension - 1].size()) break;
+      indices[dimension - 1] = 0;
+    }
+  }
+}
+
+template <typename T>
+T MultidimensionalQuadrature<T>::reduce(
+    size_t n_points, const std::function<T(size_t, size_t)>& sum) const {
+  const auto n_chunks = (n_points + kChunkSize - 1) / kChunkSize;
+  std::vector<T> partials(n_chunks);
+  std::atomic<size_t> next_chunk(0);
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  auto work = [&]() {
+    try {
+      for (auto chunk = next_chunk++; chunk < n_chunks && !failed;
+           chunk = next_chunk++) {
+        const auto begin = chunk * kChunkSize;
+        partials[chunk] = sum(begin, std::min(n_points, begin + kChunkSize));
+      }
+    } catch (...) {
+      if (!failed.exchange(true)) error = std::current_exception();
+    }
+  };
+
+  const auto n_threads = std::min(n_threads_, n_chunks);
+  std::vector<std::thread> threads;
+  for (auto index = 1ul; index < n_threads; ++index) threads.emplace_back(work);
+  work();
+  for (auto& thread : threads) thread.join();
+  if (error) std::rethrow_exception(error);
+
+  auto total = T(0);
+  for (const auto partial : partials) total += partial;
+  return total;
+}
+
+template <typename T>
+T MultidimensionalQuadrature<T>::operator()(const Function& f,
+                                            const Point& lower,
+                                            const Point& upper) const {
+  CHECK(!lower.empty()) << "no dimensions";
+  CHECK(lower.size() == upper.size()) << "bounds differ in dimensions";
+
+  if (grid_ == Grid::kTensorProduct) {
+    std::vector<TensorGrid> grids;
+    std::vector<T> coefficients;
+    this->grids(lower, upper, &grids, &coefficients);
+    const auto& grid = grids.front();
+    return reduce(grid.size, [&](size_t begin, size_t end) {
+      auto total = T(0);
+      forEachPoint(grid, begin, end,
+                   [&](const Point& x, T weight) { total += weight * f(x); });
+      return total;
+    });
+  }
+
+  std::vector<Point> points;
+  std::vector<T> weights;
+  sparsePoints(lower, upper, &points, &weights);
+  return reduce(points.size(), [&](size_t begin, size_t end) {
+    auto total = T(0);
+    for (auto index = begin; index < end; ++index) {
+      total += weights[index] * f(points[index]);
+    }
+    return total;
+  });
+}
+
+template <typename T>
+size_t MultidimensionalQuadrature<T>::nPoints(size_t n_dimensions) const {
+  const Point lower(n_dimensions, T(0));
+  const Point upper(n_dimensions, T(1));
+  if (grid_ == Grid::kTensorProduct) {
+    std::vector<TensorGrid> grids;
+    std::vector<T> coefficients;
+    this->grids(lower, upper, &grids, &coefficients);
+    return grids.front().size;
+  }
+
+  std::vector<Point> points;
+  std::vector<T> weights;
+  sparsePoints(lower, upper, &points, &weights);
+  return points.size();
+}
+
+// Rule making the one dimensional TRule, e.g. makeRule<double, Simpson>().
+template <typename T, template <typename> class TRule>
+typename MultidimensionalQuadrature<T>::Rule makeRule() {
+  return [](size_t nUnits) -> std::unique_ptr<Quadrature<T>> {
+    return std::make_unique<TRule<T>>(nUnits);
+  };
+}
+
+}  // namespace Alexandria
+
+#endif  // INTEGRATION_MULTIDIMENSIONAL_QUADRATURE_H_
@@ -1,8 +1,9 @@
 #ifndef INTEGRATION_QUADRATURE_H_
 #define INTEGRATION_QUADRATURE_H_
 
+#include <algorithm>
 #include <cmath>
-#include <limits>
+#include <functional>
 #include <vector>
 
 #include "util/util.h"
@@ -15,102 +16,149 @@ class Quadrature {
  public:
   using Weights = std::vector<T>;
   using Values = std::vector<T>;
+  // Evaluates ys[i] = f(xs[i]) for i < n.
+  using BatchFunction = std::function<void(const T* xs, T* ys, size_t n)>;
+
+  // Most abscissas passed to a BatchFunction at once.
+  static constexpr size_t kBatchSize = 256;
 
   virtual ~Quadrature() {}
 
   // Integrates the function f between x_min and x_max.
   T operator()(const std::function<T(T)>& f, T x_min, T x_max) const {
-    CHECK(x_min < x_max) << "x_min >= x_max";
+    return (*this)(
+        [&f](const T* xs, T* ys, size_t n) {
+          std::transform(xs, xs + n, ys, f);
+        },
+        x_min, x_max);
+  }
 
-    const auto& weights = weightsImpl();
-    const auto values = valuesImpl(f, x_min, x_max);
+  // Integrates f between x_min and x_max, evaluating up to kBatchSize
+  // abscissas per call.  The weighted sum is accumulated block by block, so
+  // the extra memory does not grow with the number of units.
+  T operator()(const BatchFunction& f, T x_min, T x_max) const {
+    CHECK(x_min < x_max) << "x_min >= x_max";
 
-    return std::inner_product(cbegin(weights), cend(weights), cbegin(values),
-                              0.0);
+    return batchImpl(f, x_min, x_max);
   }
 
   size_t nUnits() const { return nUnitsImpl(); }
 
+  // Number of distinct abscissas, each evaluated once per integral.
+  size_t nNodes() const { return weightsImpl().size(); }
+
+  // The abscissas and weights of the rule on [x_min, x_max]; the integral is
+  // the weighted sum of f at the abscissas.
+  void nodes(T x_min, T x_max, Values* xs, Weights* weights) const {
+    CHECK(x_min < x_max) << "x_min >= x_max";
+
+    nodesImpl(x_min, x_max, xs, weights);
+  }
+
  private:
   virtual const Weights& weightsImpl() const = 0;
-  virtual Values valuesImpl(const std::function<T(T)>& f, T x_min,
-                            T x_max) const = 0;
+  virtual void nodesImpl(T x_min, T x_max, Values* xs,
+                         Weights* weights) const = 0;
+  virtual T batchImpl(const BatchFunction& f, T x_min, T x_max) const = 0;
   virtual size_t nUnitsImpl() const = 0;
 };
 
+template <typename T>
+constexpr size_t Quadrature<T>::kBatchSize;
+
 // Register templates for different quadrature methods.
 // Weight are quadrature weights.
 // Lambda is the normalized point to the interval (-1, 1) on the x axis.
+//
+// The template is repeated over nUnits units into a single table of nodes.
+// Nodes shared by adjacent units, the endpoints of Simpson and Gauss-Lobatto
+// rules, are merged with their weights added, so each is evaluated once.
 template <typename T>
 class QuadratureTemplate : public Quadrature<T> {
  public:
   using Weights = typename QuadratureTemplate<T>::Weights;
   using Values = typename QuadratureTemplate<T>::Values;
+  using BatchFunction = typename QuadratureTemplate<T>::BatchFunction;
   using WeightTemplate = std::vector<T>;
   using LambdaTemplate = std::vector<T>;
 
   QuadratureTemplate(size_t nUnits, const WeightTemplate& weightTemplate,
-                     const LambdaTemplate& lambdaTemplate)
-      : nUnits_(nUnits),
-        weightTemplate_(weightTemplate),
-        lambdaTemplate_(lambdaTemplate) {
-    CHECK(nUnits_ > 0) << "nUnits == 0";
-  }
+                     const LambdaTemplate& lambdaTemplate);
   virtual ~QuadratureTemplate() {}
 
  private:
-  const Weights& weightsImpl() const final;
-  Values valuesImpl(const std::function<T(T)>& fn, T x_min,
-                    T x_max) const final;
+  const Weights& weightsImpl() const final { return weights_; }
+  void nodesImpl(T x_min, T x_max, Values* xs, Weights* weights) const final;
+  T batchImpl(const BatchFunction& f, T x_min, T x_max) const final;
   size_t nUnitsImpl() const final { return nUnits_; }
 
   size_t nUnits_;
-  WeightTemplate weightTemplate_;
-  LambdaTemplate lambdaTemplate_;
-  mutable Weights weights_cache_;
+  // Node positions in units from x_min, in [0, nUnits].
+  std::vector<T> positions_;
+  Weights weights_;
 };
 
 template <typename T>
-auto QuadratureTemplate<T>::weightsImpl() const -> const Weights& {
-  // TODO(alvin): make this more efficient by not double counting.
-  if (weights_cache_.empty()) {
-    weights_cache_.reserve(weightTemplate_.size() * this->nUnits());
-    for (auto index = 0ul; index < this->nUnits(); ++index) {
-      for (const auto& weight : weightTemplate_) {
-        weights_cache_.emplace_back(weight);
+QuadratureTemplate<T>::QuadratureTemplate(size_t nUnits,
+                                          const WeightTemplate& weightTemplate,
+                                          const LambdaTemplate& lambdaTemplate)
+    : nUnits_(nUnits) {
+  CHECK(nUnits_ > 0) << "nUnits == 0";
+  CHECK(weightTemplate.size() == lambdaTemplate.size())
+      << "weight and lambda templates differ in size";
+
+  positions_.reserve(lambdaTemplate.size() * nUnits_);
+  weights_.reserve(weightTemplate.size() * nUnits_);
+  for (auto unit = 0ul; unit < nUnits_; ++unit) {
+    for (auto index = 0ul; index < lambdaTemplate.size(); ++index) {
+      const auto position = unit + (lambdaTemplate[index] + 1.0) / 2.0;
+      if (!positions_.empty() && positions_.back() == position) {
+        weights_.back() += weightTemplate[index];
+      } else {
+        positions_.emplace_back(position);
+        weights_.emplace_back(weightTemplate[index]);
       }
     }
   }
+}
+
+template <typename T>
+void QuadratureTemplate<T>::nodesImpl(T x_min, T x_max, Values* xs,
+                                      Weights* weights) const {
+  const auto h = (x_max - x_min) / this->nUnits();
 
-  return weights_cache_;
+  xs->resize(positions_.size());
+  weights->resize(weights_.size());
+  for (auto index = 0ul; index < positions_.size(); ++index) {
+    (*xs)[index] = x_min + positions_[index] * h;
+    (*weights)[index] = weights_[index] * h / 2.0;
+  }
 }
 
 template <typename T>
-auto QuadratureTemplate<T>::valuesImpl(const std::function<T(T)>& f, T x_min,
-                                       T x_max) const -> Values {
+T QuadratureTemplate<T>::batchImpl(const BatchFunction& f, T x_min,
+                                   T x_max) const {
+  constexpr auto kBatchSize = Quadrature<T>::kBatchSize;
   const auto h = (x_max - x_min) / this->nUnits();
+  const auto n_nodes = weights_.size();
 
-  // memoize to reduce the number of calls to fn
-  auto x_memoized = std::numeric_limits<T>::quiet_NaN();
-  auto f_memoized = T(0);
-
-  Values values;
-  values.reserve(lambdaTemplate_.size() * this->nUnits());
-
-  // TODO(alvin): make this more efficient by not double counting.
-  for (auto index = 0ul; index < this->nUnits(); ++index) {
-    const auto x_start = x_min + index * h;
-    for (const auto& lambda : lambdaTemplate_) {
-      const auto x = x_start + (lambda + 1.0) / 2.0 * h;
-      if (!almostEqual(x, x_memoized)) {
-        x_memoized = x;
-        f_memoized = f(x);
-      }
-      values.emplace_back(f_memoized * h / 2.0);
+  T xs[kBatchSize];
+  T ys[kBatchSize];
+
+  auto sum = T(0);
+  for (auto begin = 0ul; begin < n_nodes; begin += kBatchSize) {
+    const auto n = std::min(kBatchSize, n_nodes - begin);
+    for (auto index = 0ul; index < n; ++index) {
+      xs[index] = x_min + positions_[begin + index] * h;
+    }
+
+    f(xs, ys, n);
+    for (auto index = 0ul; index < n; ++index) {
+      sum += weights_[begin + index] * ys[index];
     }
   }
 
-  return values;
+  return sum * h / 2.0;
 }
 
 template <typename T>
@@ -0,0 +1,92 @@
+#include "integration/adaptive_quadrature.h"
+
+#include <cmath>
+
+#include "integration/quadrature.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+TEST(AdaptiveQuadrature, GaussKronrod15) {
+  using Alexandria::GaussKronrod15;
+
+  GaussKronrod15<double> integrate;
+
+  auto result1 =
+      integrate([](double x) { return std::cos(x); }, -M_PI_2, M_PI_2);
+  EXPECT_NEAR(result1.value, 2, 1E-12);
+  EXPECT_TRUE(result1.converged);
+  EXPECT_EQ(result1.n_evaluations, 15);
+
+  auto result2 = integrate([](double x) { return std::exp(x); }, 0, 1);
+  EXPECT_NEAR(result2.value, std::exp(1.0) - 1, 1E-12);
+  EXPECT_LE(std::abs(result2.value - (std::exp(1.0) - 1)),
+            result2.error + 1E-15);
+}
+
+TEST(AdaptiveQuadrature, GaussKronrod21) {
+  using Alexandria::GaussKronrod21;
+
+  GaussKronrod21<double> integrate;
+
+  auto result = integrate([](double x) { return std::sin(x); }, 0, M_PI);
+  EXPECT_NEAR(result.value, 2, 1E-12);
+  EXPECT_TRUE(result.converged);
+  EXPECT_EQ(result.n_evaluations, 21);
+}
+
+TEST(AdaptiveQuadrature, Peaked) {
+  using Alexandria::GaussKronrod21;
+  using Alexandria::Simpson;
+
+  // Sharp peak at 0; the exact integral is 200 atan(100).
+  auto f = [](double x) { return 1 / (1E-4 + x * x); };
+  const auto exact = 200 * std::atan(100.0);
+
+  GaussKronrod21<double> integrate(1E-8, 1E-10);
+  auto result = integrate(f, -1, 1);
+  EXPECT_TRUE(result.converged);
+  EXPECT_NEAR(result.value, exact, 1E-8 * exact);
+  EXPECT_LE(std::abs(result.value - exact), result.error);
+  EXPECT_GT(result.n_intervals, 1);
+
+  // A uniform composite rule with as many points is far less accurate.
+  Simpson<double> simpson(result.n_evaluations / 2);
+  EXPECT_GT(std::abs(simpson(f, -1, 1) - exact), 1E-6 * exact);
+}
+
+TEST(AdaptiveQuadrature, Batch) {
+  using Alexandria::GaussKronrod15;
+
+  GaussKronrod15<double> integrate(1E-12, 0);
+
+  auto max_n = 0ul;
+  auto result = integrate(
+      [&max_n](const double* xs, double* ys, size_t n) {
+        max_n = std::max(max_n, n);
+        for (auto index = 0ul; index < n; ++index) {
+          ys[index] = std::sqrt(xs[index]);
+        }
+      },
+      0, 1);
+
+  EXPECT_NEAR(result.value, 2.0 / 3.0, 1E-10);
+  EXPECT_EQ(max_n, 2 * integrate.nPoints());
+}
+
+TEST(AdaptiveQuadrature, MaxIntervals) {
+  using Alexandria::GaussKronrod15;
+
+  GaussKronrod15<double> integrate(1E-14, 0, 3);
+
+  auto result =
+      integrate([](double x) { return 1 / std::sqrt(std::abs(x)); }, -1, 1);
+  EXPECT_FALSE(result.converged);
+  EXPECT_EQ(result.n_intervals, 3);
+}
@@ -0,0 +1,110 @@
+#include "integration/multidimensional_quadrature.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "integration/quadrature.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+using Alexandria::GaussLegendre3;
+using Alexandria::Simpson;
+using Alexandria::makeRule;
+
+using Integrator = Alexandria::MultidimensionalQuadrature<double>;
+using Grid = Integrator::Grid;
+
+namespace {
+
+double exponential(const std::vector<double>& x) {
+  auto sum = 0.0;
+  for (const auto xi : x) sum += xi;
+  return std::exp(sum);
+}
+
+}  // namespace
+
+TEST(MultidimensionalQuadrature, TensorProduct) {
+  Integrator integrate(makeRule<double, Simpson>(), Grid::kTensorProduct, 3);
+
+  // Simpson is exact for cubics in each variable.
+  auto cubic = [](const std::vector<double>& x) {
+    return x[0] * x[0] * x[0] * x[1] + x[1] * x[1];
+  };
+  EXPECT_NEAR(integrate(cubic, {0, -1}, {1, 2}), 0.375 + 3, 1E-12);
+
+  for (auto n_dimensions = 2ul; n_dimensions <= 4; ++n_dimensions) {
+    const std::vector<double> lower(n_dimensions, 0);
+    const std::vector<double> upper(n_dimensions, 1);
+    EXPECT_NEAR(integrate(exponential, lower, upper),
+                std::pow(std::exp(1.0) - 1, n_dimensions), 1E-4);
+  }
+  EXPECT_EQ(integrate.nPoints(3), 9 * 9 * 9);
+}
+
+TEST(MultidimensionalQuadrature, Smolyak) {
+  const auto exact = std::pow(std::exp(1.0) - 1, 6);
+  const std::vector<double> lower(6, 0);
+  const std::vector<double> upper(6, 1);
+
+  // The sparse grid is about as accurate as the tensor product of the same
+  // level with a fraction of its points.
+  Integrator sparse(makeRule<double, Simpson>(), Grid::kSmolyak, 3);
+  Integrator tensor(makeRule<double, Simpson>(), Grid::kTensorProduct, 3);
+  const auto sparse_error = std::abs(sparse(exponential, lower, upper) - exact);
+  const auto tensor_error = std::abs(tensor(exponential, lower, upper) - exact);
+  EXPECT_LT(sparse_error, 1.1 * tensor_error);
+  EXPECT_EQ(tensor.nPoints(6), 531441);
+  EXPECT_EQ(sparse.nPoints(6), 14337);
+
+  // Level 1 is the tensor product of level 1.
+  Integrator level1(makeRule<double, GaussLegendre3>(), Grid::kSmolyak, 1);
+  Integrator product1(makeRule<double, GaussLegendre3>(),
+                      Grid::kTensorProduct, 1);
+  EXPECT_EQ(level1(exponential, {0, 0, 0}, {1, 2, 3}),
+            product1(exponential, {0, 0, 0}, {1, 2, 3}));
+
+  // Converges with the level.
+  auto previous = 1.0;
+  for (auto level = 1ul; level <= 5; ++level) {
+    Integrator integrate(makeRule<double, Simpson>(), Grid::kSmolyak, level);
+    const auto error = std::abs(integrate(exponential, lower, upper) - exact);
+    EXPECT_LT(error, previous) << "level " << level;
+    previous = error;
+  }
+}
+
+TEST(MultidimensionalQuadrature, Deterministic) {
+  auto f = [](const std::vector<double>& x) {
+    return std::sin(x[0] * x[1]) + std::cos(x[2] - x[3]) * x[4];
+  };
+  const std::vector<double> lower = {0, 0, 0, 0, 0};
+  const std::vector<double> upper = {1, 2, 1, 2, 1};
+
+  for (const auto grid : {Grid::kTensorProduct, Grid::kSmolyak}) {
+    Integrator serial(makeRule<double, Simpson>(), grid, 4, 1);
+    const auto expected = serial(f, lower, upper);
+    for (const auto n_threads : {2ul, 3ul, 8ul}) {
+      Integrator parallel(makeRule<double, Simpson>(), grid, 4, n_threads);
+      EXPECT_EQ(parallel(f, lower, upper), expected);
+    }
+  }
+}
+
+TEST(MultidimensionalQuadrature, Exception) {
+  Integrator integrate(makeRule<double, Simpson>(), Grid::kTensorProduct, 4,
+                       4);
+  auto f = [](const std::vector<double>& x) {
+    if (x[0] > 0.5 && x[1] > 0.5) throw std::runtime_error("f");
+    return 1.0;
+  };
+  EXPECT_THROW(integrate(f, {0, 0, 0, 0}, {1, 1, 1, 1}), std::runtime_error);
+}
@@ -1,6 +1,7 @@
 #include "integration/quadrature.h"
 
 #include <iostream>
+#include <vector>
 
 #include "util/util.h"
 
@@ -87,3 +88,78 @@ TEST(Quadrature, GaussLegendre4) {
       integrate([](double x) { return std::cos(x); }, -M_PI_2, M_PI_2);
   EXPECT_NEAR(result2, 2, epsilon);
 }
+
+TEST(Quadrature, Batch) {
+  using Alexandria::GaussLobatto5;
+  using Alexandria::Quadrature;
+
+  GaussLobatto5<double> integrate(1000);
+
+  auto max_n = 0ul;
+  auto n_values = 0ul;
+  auto result = integrate(
+      [&](const double* xs, double* ys, size_t n) {
+        max_n = std::max(max_n, n);
+        n_values += n;
+        for (auto index = 0ul; index < n; ++index) {
+          ys[index] = std::cos(xs[index]);
+        }
+      },
+      -M_PI_2, M_PI_2);
+
+  EXPECT_NEAR(result, 2, 1E-12);
+  EXPECT_NEAR(result,
+              integrate([](double x) { return std::cos(x); }, -M_PI_2, M_PI_2),
+              1E-12);
+  EXPECT_LE(max_n, Quadrature<double>::kBatchSize);
+  // Adjacent units share their endpoints.
+  EXPECT_EQ(n_values, 4001);
+}
+
+TEST(Quadrature, SharedEndpoints) {
+  using Alexandria::GaussLegendre3;
+  using Alexandria::GaussLobatto4;
+  using Alexandria::Simpson;
+
+  auto n_calls = 0;
+  auto f = [&n_calls](double x) {
+    ++n_calls;
+    return x * x;
+  };
+
+  Simpson<double> simpson(20);
+  EXPECT_NEAR(simpson(f, 0, 3), 9, 1E-12);
+  EXPECT_EQ(n_calls, 41);
+  EXPECT_EQ(simpson.nNodes(), 41);
+
+  n_calls = 0;
+  GaussLobatto4<double> lobatto(10);
+  EXPECT_NEAR(lobatto(f, 0, 3), 9, 1E-12);
+  EXPECT_EQ(n_calls, 31);
+
+  // Gauss-Legendre nodes are interior so nothing is shared.
+  n_calls = 0;
+  GaussLegendre3<double> legendre(10);
+  EXPECT_NEAR(legendre(f, 0, 3), 9, 1E-12);
+  EXPECT_EQ(n_calls, 30);
+}
+
+TEST(Quadrature, Nodes) {
+  using Alexandria::Simpson;
+
+  Simpson<double> simpson(2);
+  std::vector<double> xs;
+  std::vector<double> weights;
+  simpson.nodes(1, 3, &xs, &weights);
+  EXPECT_EQ(xs, std::vector<double>({1, 1.5, 2, 2.5, 3}));
+  EXPECT_EQ(weights.size(), 5);
+  EXPECT_NEAR(weights[0], 1.0 / 6.0, 1E-15);
+  EXPECT_NEAR(weights[1], 4.0 / 6.0, 1E-15);
+  EXPECT_NEAR(weights[2], 2.0 / 6.0, 1E-15);
+
+  auto sum = 0.0;
+  for (auto index = 0ul; index < xs.size(); ++index) {
+    sum += weights[index] * xs[index] * xs[index];
+  }
+  EXPECT_NEAR(sum, simpson([](double x) { return x * x; }, 1, 3), 1E-12);
+}
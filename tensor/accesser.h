@@ -10,17 +10,21 @@
 namespace Alexandria {
 
 // This class relates the shape of the tensor to elements in a flat array.
+//
+// The strides are those cached by the interned shape, so constructing and
+// copying an Accesser costs a pointer copy.
 class Accesser {
  public:
-  using Strides = std::vector<size_t>;
+  using Strides = Shape::Strides;
 
   Accesser() {}
-  explicit Accesser(const Shape* shape);
+  explicit Accesser(const Shape* shape) : shape_(*shape) {}
 
   // Calculate the flat index from the element address.
   size_t flatIndex(const Address& address) const {
-    CHECK_EQ(address.size(), strides_.size()) << "sizes not equal";
-    return std::inner_product(strides_.cbegin(), strides_.cend(),
+    const auto& strides = shape_.strides();
+    CHECK_EQ(address.size(), strides.size()) << "sizes not equal";
+    return std::inner_product(strides.cbegin(), strides.cend(),
                               address.cbegin(), 0ul);
   }
 
@@ -38,8 +42,7 @@ class Accesser {
   */
 
  private:
-  Strides strides_;
-  const Shape* shape_;
+  Shape shape_;
 };
 
 }  // namespace Alexandria
@@ -0,0 +1,218 @@
+#include "tensor/contraction_plan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+
+#include "tensor/helpers.h"
+
+namespace Alexandria {
+
+namespace {
+// Distinct contractions kept by contractionPlans().
+constexpr size_t kPlanCapacity = 1024;
+
+uint64_t hashIndices(const Indices& indices) {
+  return indices.empty() ? 0 : hash64(indices.cbegin(), indices.cend());
+}
+
+uint64_t hashShape(const Shape& shape) {
+  return shape.nDimensions() == 0 ? 0 : hash64(shape.cbegin(), shape.cend());
+}
+
+// Position of each index of indices in the sorted indices shared with other,
+// or invalid_index.
+Indices commonPositions(const Indices& indices, const Indices& other,
+                        const Indices& common) {
+  Indices result(indices.size(), invalid_index);
+  for (auto index = 0ul; index < indices.size(); ++index) {
+    if (std::find(other.cbegin(), other.cend(), indices[index]) ==
+        other.cend()) {
+      continue;
+    }
+    result[index] = static_cast<int>(
+        std::lower_bound(common.cbegin(), common.cend(), indices[index]) -
+        common.cbegin());
+  }
+  return result;
+}
+
+Indices resultPositions(const Indices& indices) {
+  Indices result(indices.size());
+  std::transform(indices.cbegin(), indices.cend(), result.begin(),
+                 [](int index) { return index >= 0 ? index : invalid_index; });
+  return result;
+}
+
+Shape::Strides resultStrides(const Indices& indices, const Shape& result_shape) {
+  Shape::Strides result(indices.size(), 0ul);
+  for (auto index = 0ul; index < indices.size(); ++index) {
+    if (indices[index] >= 0) {
+      result[index] =
+          result_shape.strides()[static_cast<size_t>(indices[index])];
+    }
+  }
+  return result;
+}
+
+// Loop dimension of an index: result indices come first, then the summed
+// indices in ascending order.
+size_t loopDimension(int index, size_t n_result, const Indices& summed) {
+  if (index >= 0) return static_cast<size_t>(index);
+  return n_result + static_cast<size_t>(std::lower_bound(summed.cbegin(),
+                                                         summed.cend(), index) -
+                                        summed.cbegin());
+}
+
+// Strides of the loop dimensions in an operand of shape with indices.
+Shape::Strides loopStrides(const Shape& shape, const Indices& indices,
+                           size_t n_result, const Indices& summed) {
+  Shape::Strides result(n_result + summed.size(), 0ul);
+  for (auto index = 0ul; index < indices.size(); ++index) {
+    result[loopDimension(indices[index], n_result, summed)] =
+        shape.strides()[index];
+  }
+  return result;
+}
+}  // namespace
+
+bool operator==(const ContractionKey& key1, const ContractionKey& key2) {
+  return key1.shape1 == key2.shape1 && key1.indices1 == key2.indices1 &&
+         key1.dense1 == key2.dense1 && key1.shape2 == key2.shape2 &&
+         key1.indices2 == key2.indices2 && key1.dense2 == key2.dense2;
+}
+
+uint64_t ContractionKeyHash::operator()(const ContractionKey& key) const {
+  auto result = hashCombine(hashShape(key.shape1), hashIndices(key.indices1));
+  result = hashCombine(result, hashShape(key.shape2));
+  result = hashCombine(result, hashIndices(key.indices2));
+  const auto dense = (key.dense1 ? 2ul : 0ul) | (key.dense2 ? 1ul : 0ul);
+  return hashCombine(result, dense);
+}
+
+ContractionPlan makeContractionPlan(const ContractionKey& key) {
+  ContractionPlan plan;
+  std::tie(plan.result_shape, std::ignore) =
+      multiplyShapes(key.shape1, key.indices1, key.shape2, key.indices2);
+
+  plan.result_positions1 = resultPositions(key.indices1);
+  plan.result_positions2 = resultPositions(key.indices2);
+
+  // Indices in both operands, in ascending order.
+  Indices common;
+  std::copy_if(key.indices1.cbegin(), key.indices1.cend(),
+               std::back_inserter(common), [&key](int index) {
+                 return std::find(key.indices2.cbegin(), key.indices2.cend(),
+                                  index) != key.indices2.cend();
+               });
+  std::sort(common.begin(), common.end());
+  plan.common_positions1 =
+      commonPositions(key.indices1, key.indices2, common);
+  plan.common_positions2 =
+      commonPositions(key.indices2, key.indices1, common);
+  plan.n_common = common.size();
+  plan.common_extent = 1;
+  for (auto index = 0ul; index < key.indices1.size(); ++index) {
+    if (plan.common_positions1[index] != invalid_index) {
+      plan.common_extent *= key.shape1[index];
+    }
+  }
+  plan.result_strides1 = resultStrides(key.indices1, plan.result_shape);
+  plan.result_strides2 = resultStrides(key.indices2, plan.result_shape);
+  // Result dimensions of both operands are counted once.
+  for (auto index = 0ul; index < key.indices2.size(); ++index) {
+    if (plan.common_positions2[index] != invalid_index) {
+      plan.result_strides2[index] = 0;
+    }
+  }
+
+  plan.strided = key.dense1 && key.dense2;
+  if (!plan.strided) return plan;
+
+  // Summed indices of either operand, in ascending order.
+  std::set<int> summed_set;
+  for (const auto* indices : {&key.indices1, &key.indices2}) {
+    for (const auto index : *indices) {
+      if (index < 0) summed_set.insert(index);
+    }
+  }
+  const Indices summed(summed_set.cbegin(), summed_set.cend());
+
+  const auto n_result = plan.result_shape.nDimensions();
+  Shape::Dims loop_dims(plan.result_shape.cbegin(), plan.result_shape.cend());
+  loop_dims.resize(n_result + summed.size());
+  for (auto index = 0ul; index < key.indices1.size(); ++index) {
+    loop_dims[loopDimension(key.indices1[index], n_result, summed)] =
+        key.shape1[index];
+  }
+  for (auto index = 0ul; index < key.indices2.size(); ++index) {
+    loop_dims[loopDimension(key.indices2[index], n_result, summed)] =
+        key.shape2[index];
+  }
+  plan.loop_shape = Shape(loop_dims);
+
+  plan.loop_strides1 = loopStrides(key.shape1, key.indices1, n_result, summed);
+  plan.loop_strides2 = loopStrides(key.shape2, key.indices2, n_result, summed);
+  plan.loop_strides_result.assign(loop_dims.size(), 0ul);
+  std::copy(plan.result_shape.strides().cbegin(),
+            plan.result_shape.strides().cend(),
+            plan.loop_strides_result.begin());
+  return plan;
+}
+
+double estimateNnz(double n_elements, double common_extent, double nnz1,
+                   double nnz2) {
+  const auto pairs = nnz1 * nnz2 / common_extent;
+  if (n_elements == 0 || pairs == 0) return 0;
+  // Expected number of distinct elements hit by pairs random draws.
+  return n_elements * -std::expm1(-pairs / n_elements);
+}
+
+bool denseResult(const ContractionPlan& plan, size_t nnz1, size_t nnz2) {
+  if (plan.strided) return true;
+  const auto n_elements = static_cast<double>(nElements(plan.result_shape));
+  return estimateNnz(n_elements, static_cast<double>(plan.common_extent),
+                     static_cast<double>(nnz1), static_cast<double>(nnz2)) >=
+         kDenseResultFraction * n_elements;
+}
+
+ContractionPlanCache& contractionPlans() {
+  static ContractionPlanCache plans(
+      [](const ContractionKey& key) {
+        return std::make_shared<const ContractionPlan>(
+            makeContractionPlan(key));
+      },
+      kPlanCapacity);
+  return plans;
+}
+
+const std::pair<Indices, Indices>& chainRuleIndices(size_t n_result,
+                                                    size_t n_term,
+                                                    size_t n_var) {
+  static std::mutex mutex;
+  static std::map<std::tuple<size_t, size_t, size_t>,
+                  std::pair<Indices, Indices>>
+      cache;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& entry = cache[std::make_tuple(n_result, n_term, n_var)];
+  if (entry.first.empty() && n_result + n_term > 0) {
+    // dF has shape {result, term}, the term derivative {term, var}.
+    entry.first.resize(n_result + n_term);
+    for (auto index = 0ul; index < entry.first.size(); ++index) {
+      entry.first[index] = static_cast<int>(
+          index < n_result ? index : n_result - index - 1);
+    }
+    entry.second.resize(n_term + n_var);
+    for (auto index = 0ul; index < entry.second.size(); ++index) {
+      entry.second[index] = static_cast<int>(
+          index < n_term ? -index - 1 : index - n_term + n_result);
+    }
+  }
+  return entry;
+}
+
+}  // namespace Alexandria
@@ -0,0 +1,103 @@
+#ifndef TENSOR_CONTRACTION_PLAN_H_
+#define TENSOR_CONTRACTION_PLAN_H_
+
+#include <memory>
+#include <utility>
+
+#include "tensor/shape.h"
+#include "util/function_cache.h"
+#include "util/util.h"
+
+namespace Alexandria {
+
+// What a contraction plan depends on: the operand shapes and indices of
+// multiply(t1, indices1, t2, indices2) and whether the operands are dense.
+struct ContractionKey {
+  Shape shape1;
+  Indices indices1;
+  bool dense1;
+  Shape shape2;
+  Indices indices2;
+  bool dense2;
+};
+
+bool operator==(const ContractionKey& key1, const ContractionKey& key2);
+
+struct ContractionKeyHash {
+  uint64_t operator()(const ContractionKey& key) const;
+};
+
+// Everything multiply() derives from a ContractionKey before touching an
+// element, computed once per distinct contraction.
+struct ContractionPlan {
+  Shape result_shape;
+
+  // Per dimension of each operand, its position in the result address, or
+  // invalid_index for summed dimensions.
+  Indices result_positions1;
+  Indices result_positions2;
+
+  // Per dimension of each operand, its position in the address of the
+  // dimensions shared by both operands, or invalid_index.  Elements of the
+  // two operands are paired when their shared addresses are equal.
+  Indices common_positions1;
+  Indices common_positions2;
+  size_t n_common;
+  // Number of elements of the shared dimensions.
+  size_t common_extent;
+
+  // Per dimension of each operand, its stride in the result, or 0 for summed
+  // dimensions.  The offset of a result element is the sum of the offsets of
+  // the paired elements.
+  Shape::Strides result_strides1;
+  Shape::Strides result_strides2;
+
+  // Both operands are dense, so multiply walks the result dimensions followed
+  // by the summed dimensions with strides instead of pairing elements.
+  bool strided;
+  Shape loop_shape;
+  // Strides of the loop dimensions in each operand and in the result, 0 where
+  // a dimension does not appear.
+  Shape::Strides loop_strides1;
+  Shape::Strides loop_strides2;
+  Shape::Strides loop_strides_result;
+};
+
+// A sparse element costs about ten times a dense one, with its address and
+// hash node, so results estimated to store at least this fraction of their
+// elements are dense.
+constexpr double kDenseResultFraction = 0.1;
+
+// Estimated number of stored elements of the result of a contraction with
+// n_elements elements, from operands storing nnz1 and nnz2 elements.  Stored
+// elements are assumed uniformly spread, so a pair agrees on the shared
+// dimensions with probability 1 / common_extent and the pairs that do land on
+// the result elements at random.
+double estimateNnz(double n_elements, double common_extent, double nnz1,
+                   double nnz2);
+
+// Whether multiply() stores the result of plan from operands storing nnz1 and
+// nnz2 elements as dense.
+bool denseResult(const ContractionPlan& plan, size_t nnz1, size_t nnz2);
+
+// Compute the plan of a contraction.  Throws std::invalid_argument like
+// multiplyShapes for invalid indices.
+ContractionPlan makeContractionPlan(const ContractionKey& key);
+
+using ContractionPlanCache =
+    FunctionCache<ContractionKey, std::shared_ptr<const ContractionPlan>,
+                  ContractionKeyHash>;
+
+// The plans of the most recently used contractions, shared by all threads.
+ContractionPlanCache& contractionPlans();
+
+// Indices of the chain rule contraction R_rv = Sum_t dF_rt dTerm_tv for the
+// numbers of dimensions of the result r, the term t and the variable v.
+// Computed once per triple.
+const std::pair<Indices, Indices>& chainRuleIndices(size_t n_result,
+                                                    size_t n_term,
+                                                    size_t n_var);
+
+}  // namespace Alexandria
+
+#endif  // TENSOR_CONTRACTION_PLAN_H_
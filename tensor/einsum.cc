@@ -0,0 +1,290 @@
+#include "tensor/einsum.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+#include "tensor/contraction_plan.h"
+#include "tensor/helpers.h"
+
+namespace Alexandria {
+
+namespace {
+using Labels = Indices;
+
+// An operand or intermediate result as estimated by the planner.
+struct Node {
+  Labels labels;
+  double size;
+  double nnz;
+  bool dense;
+  bool structured;
+};
+
+class Planner {
+ public:
+  explicit Planner(const std::vector<EinsumOperand>& operands);
+
+  EinsumPlan greedy() const;
+  EinsumPlan optimal() const;
+
+ private:
+  using Mask = uint32_t;
+
+  // Contract a and b, keeping the labels needed outside of mask.
+  Node contract(const Node& a, const Node& b, Mask mask, double* cost) const;
+
+  double extent(const Labels& labels) const;
+
+  std::vector<Node> nodes_;
+  std::map<int, size_t> dims_;
+  // Operands each label appears in.
+  std::map<int, Mask> masks_;
+};
+
+Planner::Planner(const std::vector<EinsumOperand>& operands) {
+  for (auto index = 0ul; index < operands.size(); ++index) {
+    const auto& operand = operands[index];
+    if (operand.indices.size() != operand.shape.nDimensions()) {
+      throw std::invalid_argument("one index per dimension");
+    }
+    if (!indicesUnique(operand.indices)) {
+      throw std::invalid_argument("indices are not unique");
+    }
+    for (auto dim = 0ul; dim < operand.indices.size(); ++dim) {
+      const auto label = operand.indices[dim];
+      auto iter = dims_.emplace(label, operand.shape[dim]).first;
+      if (iter->second != operand.shape[dim]) {
+        throw std::invalid_argument("index with different dimensions");
+      }
+      masks_[label] |= Mask(1) << index;
+    }
+    nodes_.push_back({operand.indices,
+                      static_cast<double>(nElements(operand.shape)),
+                      static_cast<double>(operand.nnz), operand.dense,
+                      operand.structured});
+  }
+
+  auto n_result = 0ul;
+  for (const auto& label_mask : masks_) {
+    if (label_mask.first >= 0) {
+      ++n_result;
+    } else if ((label_mask.second & (label_mask.second - 1)) == 0) {
+      throw std::invalid_argument("non-repeated summed index");
+    }
+  }
+  if (n_result == 0 ||
+      static_cast<int>(n_result) != masks_.rbegin()->first + 1) {
+    throw std::invalid_argument("result indices must be 0, 1, ... n - 1");
+  }
+}
+
+double Planner::extent(const Labels& labels) const {
+  auto result = 1.0;
+  for (const auto label : labels) result *= dims_.at(label);
+  return result;
+}
+
+Node Planner::contract(const Node& a, const Node& b, Mask mask,
+                       double* cost) const {
+  Labels all = a.labels;
+  Labels shared;
+  for (const auto label : b.labels) {
+    if (std::find(a.labels.cbegin(), a.labels.cend(), label) ==
+        a.labels.cend()) {
+      all.push_back(label);
+    } else {
+      shared.push_back(label);
+    }
+  }
+
+  Node result;
+  for (const auto label : all) {
+    if (label >= 0 || (masks_.at(label) & ~mask) != 0) {
+      result.labels.push_back(label);
+    }
+  }
+  result.size = extent(result.labels);
+  result.structured = false;
+  if (a.dense && b.dense) {
+    *cost = extent(all);
+    result.nnz = result.size;
+    result.dense = true;
+  } else {
+    // An identity or diagonal only relabels or scales the other operand.
+    *cost = a.structured ? b.nnz : b.structured ? a.nnz : a.nnz * b.nnz;
+    result.nnz = estimateNnz(result.size, extent(shared), a.nnz, b.nnz);
+    // As multiply() stores it.
+    result.dense = result.nnz >= kDenseResultFraction * result.size;
+    if (result.dense) result.nnz = result.size;
+  }
+  // multiply() has no scalar results.  The last step keeps the result labels,
+  // so only intermediate steps can sum all their labels away, and a pair that
+  // keeps a result label is always left to contract instead.
+  if (result.labels.empty()) *cost = std::numeric_limits<double>::infinity();
+  return result;
+}
+
+EinsumPlan Planner::greedy() const {
+  EinsumPlan plan{{}, 0};
+  std::vector<size_t> numbers(nodes_.size());
+  std::vector<Mask> masks(nodes_.size());
+  auto nodes = nodes_;
+  for (auto index = 0ul; index < nodes.size(); ++index) {
+    numbers[index] = index;
+    masks[index] = Mask(1) << index;
+  }
+
+  auto next = nodes_.size();
+  while (nodes.size() > 1) {
+    auto best_cost = std::numeric_limits<double>::infinity();
+    auto best_nnz = best_cost;
+    size_t best1 = 0, best2 = 1;
+    Node best_node;
+    for (auto index1 = 0ul; index1 < nodes.size(); ++index1) {
+      for (auto index2 = index1 + 1; index2 < nodes.size(); ++index2) {
+        double cost;
+        auto node = contract(nodes[index1], nodes[index2],
+                             masks[index1] | masks[index2], &cost);
+        if (cost < best_cost || (cost == best_cost && node.nnz < best_nnz)) {
+          best_cost = cost;
+          best_nnz = node.nnz;
+          best1 = index1;
+          best2 = index2;
+          best_node = std::move(node);
+        }
+      }
+    }
+
+    plan.steps.emplace_back(numbers[best1], numbers[best2]);
+    plan.cost += best_cost;
+    const auto mask = masks[best1] | masks[best2];
+    // best2 > best1, so erase it first.
+    for (const auto index : {best2, best1}) {
+      nodes.erase(nodes.begin() + static_cast<ptrdiff_t>(index));
+      numbers.erase(numbers.begin() + static_cast<ptrdiff_t>(index));
+      masks.erase(masks.begin() + static_cast<ptrdiff_t>(index));
+    }
+    nodes.push_back(std::move(best_node));
+    numbers.push_back(next++);
+    masks.push_back(mask);
+  }
+  return plan;
+}
+
+EinsumPlan Planner::optimal() const {
+  // Cheapest contraction of every subset of the operands, from the cheapest
+  // split of the subset in two.
+  const auto n_subsets = Mask(1) << nodes_.size();
+  const auto infinity = std::numeric_limits<double>::infinity();
+  std::vector<double> costs(n_subsets, infinity);
+  std::vector<Mask> splits(n_subsets, 0);
+  std::vector<Node> nodes(n_subsets);
+  for (auto index = 0ul; index < nodes_.size(); ++index) {
+    costs[Mask(1) << index] = 0;
+    nodes[Mask(1) << index] = nodes_[index];
+  }
+
+  for (Mask mask = 1; mask < n_subsets; ++mask) {
+    if ((mask & (mask - 1)) == 0) continue;
+    // Subsets hold their lowest operand on the left, so each split is
+    // visited once.
+    const auto lowest = mask & (~mask + 1);
+    for (auto left = (mask - 1) & mask; left > 0; left = (left - 1) & mask) {
+      if ((left & lowest) == 0) continue;
+      const auto right = mask ^ left;
+      double cost;
+      auto node = contract(nodes[left], nodes[right], mask, &cost);
+      cost += costs[left] + costs[right];
+      if (cost < costs[mask]) {
+        costs[mask] = cost;
+        splits[mask] = left;
+        nodes[mask] = std::move(node);
+      }
+    }
+  }
+
+  EinsumPlan plan{{}, costs[n_subsets - 1]};
+  auto next = nodes_.size();
+  // Steps of the subtree of mask, returning the number of its result.
+  std::function<size_t(Mask)> emit = [&](Mask mask) -> size_t {
+    if ((mask & (mask - 1)) == 0) {
+      auto index = 0ul;
+      while ((mask >> index) != 1) ++index;
+      return index;
+    }
+    const auto left = emit(splits[mask]);
+    const auto right = emit(mask ^ splits[mask]);
+    plan.steps.emplace_back(left, right);
+    return next++;
+  };
+  emit(n_subsets - 1);
+  return plan;
+}
+}  // namespace
+
+constexpr size_t EinsumPlan::kMaxOptimal;
+
+EinsumPlan planEinsum(const std::vector<EinsumOperand>& operands,
+                      EinsumPlan::Strategy strategy) {
+  if (operands.empty()) throw std::invalid_argument("no operands");
+  if (operands.size() > 32) throw std::invalid_argument("too many operands");
+
+  const Planner planner(operands);
+  if (strategy == EinsumPlan::kOptimal ||
+      (strategy == EinsumPlan::kAuto &&
+       operands.size() <= EinsumPlan::kMaxOptimal)) {
+    if (operands.size() > 20) {
+      throw std::invalid_argument("too many operands for the optimal order");
+    }
+    return planner.optimal();
+  }
+  return planner.greedy();
+}
+
+EinsumStep einsumStep(const Indices& labels1, const Indices& labels2,
+                      const std::vector<const Indices*>& others) {
+  auto needed = [&others](int label) {
+    return label >= 0 ||
+           std::any_of(others.cbegin(), others.cend(),
+                       [label](const Indices* labels) {
+                         return std::find(labels->cbegin(), labels->cend(),
+                                          label) != labels->cend();
+                       });
+  };
+
+  EinsumStep result;
+  for (const auto* labels : {&labels1, &labels2}) {
+    for (const auto label : *labels) {
+      if (needed(label) && std::find(result.labels.cbegin(),
+                                     result.labels.cend(),
+                                     label) == result.labels.cend()) {
+        result.labels.push_back(label);
+      }
+    }
+  }
+  if (others.empty()) std::sort(result.labels.begin(), result.labels.end());
+
+  // Kept labels map to their position in the result, the others to a summed
+  // index shared by both operands.
+  Indices summed;
+  auto index = [&result, &summed](int label) {
+    auto iter = std::find(result.labels.cbegin(), result.labels.cend(), label);
+    if (iter != result.labels.cend()) {
+      return static_cast<int>(iter - result.labels.cbegin());
+    }
+    auto summed_iter = std::find(summed.cbegin(), summed.cend(), label);
+    if (summed_iter == summed.cend()) {
+      summed.push_back(label);
+      summed_iter = summed.cend() - 1;
+    }
+    return -static_cast<int>(summed_iter - summed.cbegin()) - 1;
+  };
+  for (const auto label : labels1) result.indices1.push_back(index(label));
+  for (const auto label : labels2) result.indices2.push_back(index(label));
+  return result;
+}
+
+}  // namespace Alexandria
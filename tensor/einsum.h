@@ -0,0 +1,179 @@
+#ifndef TENSOR_EINSUM_H_
+#define TENSOR_EINSUM_H_
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "tensor/shape.h"
+#include "tensor/tensor.h"
+
+namespace Alexandria {
+
+// An operand of einsum as seen by the planner.
+struct EinsumOperand {
+  Shape shape;
+  Indices indices;
+  // Number of stored elements.
+  size_t nnz;
+  bool dense;
+  // An identity or diagonal, which multiply() contracts without visiting its
+  // elements.
+  bool structured;
+};
+
+// The order in which einsum contracts its operands, two at a time.
+struct EinsumPlan {
+  enum Strategy {
+    // Repeatedly contract the cheapest pair.
+    kGreedy,
+    // Search all orders, exponential in the number of operands.
+    kOptimal,
+    // kOptimal up to kMaxOptimal operands, kGreedy beyond.
+    kAuto,
+  };
+
+  static constexpr size_t kMaxOptimal = 8;
+
+  // Each step contracts two operands into a new one, numbered after the
+  // inputs in the order of the steps.
+  std::vector<std::pair<size_t, size_t>> steps;
+
+  // Estimated number of multiply-adds.
+  double cost;
+};
+
+// Plan the contraction of operands.  The cost of a step follows multiply():
+// the loop over all dimensions when both operands are dense, the stored
+// elements of the other operand for a structured one, every pair of stored
+// elements otherwise.  Intermediate results are stored as multiply() would
+// store them, from their estimateNnz.  Steps never sum away every label of
+// their operands, since multiply() has no scalar results.
+//
+// Throws std::invalid_argument for indices einsum does not accept.
+EinsumPlan planEinsum(const std::vector<EinsumOperand>& operands,
+                      EinsumPlan::Strategy strategy = EinsumPlan::kAuto);
+
+// One step of an einsum: the indices for multiply() of two operands with the
+// given labels, and the labels of its result.
+struct EinsumStep {
+  Indices indices1;
+  Indices indices2;
+  Indices labels;
+};
+
+// Labels still needed are kept: result labels and labels of others.  The
+// last step, without others, keeps the result labels in order.
+EinsumStep einsumStep(const Indices& labels1, const Indices& labels2,
+                      const std::vector<const Indices*>& others);
+
+// The n-ary generalization of multiply().  Indices follow multiply(): a
+// non-negative index is the dimension of the result, a negative index is
+// summed over and must appear in at least two operands.  E.g.
+//   R_il = Sum_jk A_ij B_jk C_kl
+//   einsum<double>({&a, &b, &c}, {{0, -1}, {-1, -2}, {-2, 1}})
+//
+// The operands are contracted pairwise in the order chosen by planEinsum,
+// whatever the order they are given in.  Kronecker operands are replaced by
+// their factors; Kronecker intermediates are contracted element by element.
+template <typename T>
+Tensor<T> einsum(const std::vector<const Tensor<T>*>& operand_tensors,
+                 const std::vector<Indices>& operand_indices,
+                 EinsumPlan::Strategy strategy = EinsumPlan::kAuto) {
+  using Dense = typename Tensor<T>::Dense;
+  using ConstDiagonal = typename Tensor<T>::ConstDiagonal;
+  using Diagonal = typename Tensor<T>::Diagonal;
+  using Kronecker = typename Tensor<T>::Kronecker;
+
+  if (operand_tensors.size() != operand_indices.size()) {
+    throw std::invalid_argument("one indices per tensor");
+  }
+  std::vector<const Tensor<T>*> tensors;
+  std::vector<Indices> indices;
+  std::function<void(const Tensor<T>&, const Indices&)> expand =
+      [&](const Tensor<T>& t, const Indices& labels) {
+        if (!t.template isType<Kronecker>()) {
+          if (labels.size() != t.shape().nDimensions()) {
+            throw std::invalid_argument("one index per dimension");
+          }
+          tensors.push_back(&t);
+          indices.push_back(labels);
+          return;
+        }
+        const auto& kronecker = t.template reference<Kronecker>();
+        for (const auto& factor :
+             {std::make_pair(&kronecker.factor1(), &kronecker.positions1()),
+              std::make_pair(&kronecker.factor2(), &kronecker.positions2())}) {
+          Indices factor_labels;
+          for (const auto position : *factor.second) {
+            factor_labels.push_back(labels.at(static_cast<size_t>(position)));
+          }
+          expand(*factor.first, factor_labels);
+        }
+      };
+  for (auto index = 0ul; index < operand_tensors.size(); ++index) {
+    expand(*operand_tensors[index], operand_indices[index]);
+  }
+
+  std::vector<EinsumOperand> operands;
+  for (auto index = 0ul; index < tensors.size(); ++index) {
+    const auto& t = *tensors[index];
+    operands.push_back({t.shape(), indices[index], t.size(),
+                        t.template isType<Dense>(),
+                        t.template isType<ConstDiagonal>() ||
+                            t.template isType<Diagonal>()});
+  }
+  const auto plan = planEinsum(operands, strategy);
+
+  if (tensors.size() == 1) {
+    // Only a permutation of the dimensions.
+    const auto& t = *tensors.front();
+    const auto& labels = indices.front();
+    Shape::Dims dims(labels.size());
+    for (auto index = 0ul; index < labels.size(); ++index) {
+      dims[static_cast<size_t>(labels[index])] = t.shape()[index];
+    }
+    Address source(labels.size());
+    return Tensor<T>::generate(Shape(dims), [&](const Address& address) {
+      for (auto index = 0ul; index < labels.size(); ++index) {
+        source[index] = address[static_cast<size_t>(labels[index])];
+      }
+      return t.at(source);
+    });
+  }
+
+  // Operands by number, the intermediate results owned.
+  auto values = tensors;
+  auto labels = indices;
+  std::vector<bool> live(tensors.size(), true);
+  std::vector<std::unique_ptr<Tensor<T>>> results;
+  for (const auto& step : plan.steps) {
+    live[step.first] = false;
+    live[step.second] = false;
+    std::vector<const Indices*> others;
+    for (auto index = 0ul; index < live.size(); ++index) {
+      if (live[index]) others.push_back(&labels[index]);
+    }
+
+    const auto contraction =
+        einsumStep(labels[step.first], labels[step.second], others);
+    results.emplace_back(new Tensor<T>(
+        multiplyPair(*values[step.first], contraction.indices1,
+                     *values[step.second], contraction.indices2)));
+    values.push_back(results.back().get());
+    labels.push_back(contraction.labels);
+    live.push_back(true);
+
+    // Intermediates are not needed once contracted.
+    for (const auto operand : {step.first, step.second}) {
+      if (operand >= tensors.size()) results[operand - tensors.size()].reset();
+    }
+  }
+  return *results.back();
+}
+
+}  // namespace Alexandria
+
+#endif  // TENSOR_EINSUM_H_
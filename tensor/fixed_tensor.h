@@ -0,0 +1,248 @@
+#ifndef TENSOR_FIXED_TENSOR_H_
+#define TENSOR_FIXED_TENSOR_H_
+
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include "tensor/helpers.h"
+#include "tensor/shape.h"
+#include "tensor/tensor.h"
+
+namespace Alexandria {
+
+// Shape with dimensions known at compile time, e.g. FixedShape<3, 3>.
+//
+// The strides and the flat index of an address are constant expressions, so
+// loops over a fixed shape unroll and accesses with constant indices fold.
+template <size_t... Dims>
+struct FixedShape {
+  static_assert(sizeof...(Dims) > 0, "a fixed shape needs a dimension");
+
+  static constexpr size_t nDimensions() { return sizeof...(Dims); }
+
+  static constexpr size_t dim(size_t index) {
+    const size_t dims[] = {Dims...};
+    return dims[index];
+  }
+
+  static constexpr size_t nElements() {
+    auto result = 1ul;
+    for (auto index = 0ul; index < nDimensions(); ++index) {
+      result *= dim(index);
+    }
+    return result;
+  }
+
+  // Row-major stride of dimension index.
+  static constexpr size_t stride(size_t index) {
+    auto result = 1ul;
+    for (auto dim_index = index + 1; dim_index < nDimensions(); ++dim_index) {
+      result *= dim(dim_index);
+    }
+    return result;
+  }
+
+  template <typename... Index>
+  static constexpr size_t flatIndex(Index... index) {
+    static_assert(sizeof...(Index) == sizeof...(Dims),
+                  "one index per dimension");
+    const size_t address[] = {static_cast<size_t>(index)...};
+    auto result = 0ul;
+    for (auto dim_index = 0ul; dim_index < nDimensions(); ++dim_index) {
+      result = result * dim(dim_index) + address[dim_index];
+    }
+    return result;
+  }
+
+  static Shape shape() { return Shape({Dims...}); }
+};
+
+// Dense tensor with dimensions known at compile time, stored inline.
+//
+// Meant for small kernels, e.g. 3x3 or 28x28, where the bookkeeping of
+// Tensor<T> (a runtime Shape, a virtual call and a CHECK per access) costs more
+// than the arithmetic.  Converts to and from Tensor<T>.
+template <typename T, size_t... Dims>
+class FixedTensor {
+ public:
+  using Layout = FixedShape<Dims...>;
+  using Data = std::array<T, Layout::nElements()>;
+
+  // Zero initialized.
+  FixedTensor() : data_() {}
+  explicit FixedTensor(const Data& data) : data_(data) {}
+
+  // Throws if t does not have the fixed shape.
+  explicit FixedTensor(const Tensor<T>& t) {
+    if (t.shape() != Layout::shape()) {
+      throw std::invalid_argument("shape does not match the fixed shape");
+    }
+    if (t.template isType<typename Tensor<T>::Dense>()) {
+      const auto& dense = t.template reference<typename Tensor<T>::Dense>();
+      std::copy(dense.data().cbegin(), dense.data().cend(), data_.begin());
+    } else {
+      Address address(Layout::nDimensions(), 0ul);
+      for (auto& value : data_) {
+        value = t.at(address);
+        advance(&address, t.shape());
+      }
+    }
+  }
+
+  static constexpr size_t nDimensions() { return Layout::nDimensions(); }
+  static constexpr size_t size() { return Layout::nElements(); }
+  static Shape shape() { return Layout::shape(); }
+
+  template <typename... Index>
+  T operator()(Index... index) const {
+    return data_[Layout::flatIndex(index...)];
+  }
+
+  template <typename... Index>
+  T& operator()(Index... index) {
+    return data_[Layout::flatIndex(index...)];
+  }
+
+  const Data& data() const { return data_; }
+  Data& data() { return data_; }
+
+  // A dense copy.
+  Tensor<T> toTensor() const {
+    return Tensor<T>(typename Tensor<T>::Dense(
+        shape(), std::vector<T>(data_.cbegin(), data_.cend())));
+  }
+
+ private:
+  Data data_;
+};
+
+template <typename T, size_t... Dims>
+bool operator==(const FixedTensor<T, Dims...>& t1,
+                const FixedTensor<T, Dims...>& t2) {
+  return t1.data() == t2.data();
+}
+
+template <typename T, size_t... Dims>
+bool operator!=(const FixedTensor<T, Dims...>& t1,
+                const FixedTensor<T, Dims...>& t2) {
+  return !(t1 == t2);
+}
+
+// Matrix multiply R_ik = Sum_j S_ij T_jk, the fixed counterpart of
+// multiply(S, {0, -1}, T, {-1, 1}).
+template <typename T, size_t I, size_t J, size_t K>
+FixedTensor<T, I, K> multiply(const FixedTensor<T, I, J>& t1,
+                              const FixedTensor<T, J, K>& t2) {
+  FixedTensor<T, I, K> result;
+  for (auto i = 0ul; i < I; ++i) {
+    for (auto j = 0ul; j < J; ++j) {
+      const auto value = t1(i, j);
+      for (auto k = 0ul; k < K; ++k) result(i, k) += value * t2(j, k);
+    }
+  }
+  return result;
+}
+
+// Dense tensor with a rank known at compile time and dimensions set at run
+// time, e.g. a batch of images as RankedTensor<double, 3>.
+//
+// Indexing takes exactly N indices and loops over a fixed number of strides
+// without checks, so it unrolls.  Converts to and from Tensor<T>.
+template <typename T, size_t N>
+class RankedTensor {
+ public:
+  static_assert(N > 0, "a ranked tensor needs a dimension");
+
+  using Dims = std::array<size_t, N>;
+  using Data = std::vector<T>;
+
+  explicit RankedTensor(const Dims& dims, T value = 0)
+      : dims_(dims), strides_(rowMajor(dims)), data_(nElements(dims), value) {}
+
+  // Throws if t does not have rank N.
+  explicit RankedTensor(const Tensor<T>& t)
+      : dims_(rankedDims(t.shape())),
+        strides_(rowMajor(dims_)),
+        data_(nElements(dims_)) {
+    if (t.template isType<typename Tensor<T>::Dense>()) {
+      const auto& dense = t.template reference<typename Tensor<T>::Dense>();
+      std::copy(dense.data().cbegin(), dense.data().cend(), data_.begin());
+    } else {
+      Address address(N, 0ul);
+      for (auto& value : data_) {
+        value = t.at(address);
+        advance(&address, t.shape());
+      }
+    }
+  }
+
+  static constexpr size_t nDimensions() { return N; }
+  size_t size() const { return data_.size(); }
+  const Dims& dims() const { return dims_; }
+  Shape shape() const {
+    return Shape(Shape::Dims(dims_.cbegin(), dims_.cend()));
+  }
+
+  template <typename... Index>
+  T operator()(Index... index) const {
+    return data_[flatIndex(index...)];
+  }
+
+  template <typename... Index>
+  T& operator()(Index... index) {
+    return data_[flatIndex(index...)];
+  }
+
+  const Data& data() const { return data_; }
+  Data& data() { return data_; }
+
+  // A dense copy.
+  Tensor<T> toTensor() const {
+    return Tensor<T>(typename Tensor<T>::Dense(shape(), data_));
+  }
+
+ private:
+  static Dims rankedDims(const Shape& shape) {
+    if (shape.nDimensions() != N) {
+      throw std::invalid_argument("shape does not have the fixed rank");
+    }
+    Dims dims{};
+    std::copy(shape.cbegin(), shape.cend(), dims.begin());
+    return dims;
+  }
+
+  static Dims rowMajor(const Dims& dims) {
+    Dims strides;
+    strides[N - 1] = 1;
+    for (auto index = N - 1; index > 0; --index) {
+      strides[index - 1] = strides[index] * dims[index];
+    }
+    return strides;
+  }
+
+  static size_t nElements(const Dims& dims) {
+    auto result = 1ul;
+    for (const auto dim : dims) result *= dim;
+    return result;
+  }
+
+  template <typename... Index>
+  size_t flatIndex(Index... index) const {
+    static_assert(sizeof...(Index) == N, "one index per dimension");
+    const size_t address[] = {static_cast<size_t>(index)...};
+    auto result = 0ul;
+    for (auto dim_index = 0ul; dim_index < N; ++dim_index) {
+      result += strides_[dim_index] * address[dim_index];
+    }
+    return result;
+  }
+
+  Dims dims_;
+  Dims strides_;
+  Data data_;
+};
+
+}  // namespace Alexandria
+
+#endif  // TENSOR_FIXED_TENSOR_H_
@@ -121,21 +121,25 @@ bool indicesUnique(Indices indices) {
 
 Address increment(Address address, const Shape& shape) {
   CHECK(address.size() > 0) << "empty address";
-  ++address.back();
-
-  auto carry = 0ul;
-  auto iter = address.rbegin();
-  auto dim_iter = shape.crbegin();
-
-  for (; iter != address.rend(); ++iter, ++dim_iter) {
-    auto value = *iter;
-    const auto dim = *dim_iter;
-    value += carry;
-    carry = value / dim;
-    *iter = value % dim;
-    if (carry == 0) break;
-  }
+  advance(&address, shape);
   return address;
 }
 
+Odometer::Odometer(const Shape& shape)
+    : Odometer(shape, shape.strides()) {}
+
+Odometer::Odometer(const Shape& shape, Strides strides)
+    : dims_(shape.cbegin(), shape.cend()),
+      strides_(std::move(strides)),
+      spans_(dims_.size()),
+      address_(dims_.size(), 0ul),
+      offset_(0),
+      index_(0),
+      size_(nElements(shape)) {
+  CHECK_EQ(strides_.size(), dims_.size()) << "sizes not equal";
+  for (auto dim = 0ul; dim < dims_.size(); ++dim) {
+    spans_[dim] = strides_[dim] * dims_[dim];
+  }
+}
+
 }  // namespace Tensor
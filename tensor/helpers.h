@@ -3,6 +3,7 @@
 
 #include "tensor/shape.h"
 #include <tuple>
+#include <vector>
 
 namespace Alexandria {
 
@@ -31,8 +32,71 @@ inline bool isEyeShape(const Shape& shape) {
                     shape.cbegin() + shape.nDimensions() / 2);
 }
 
+// Advance address to the next address of shape in row-major order, wrapping
+// to all zeros after the last.  Carries by comparison, without divisions.
+inline void advance(Address* address, const Shape& shape) {
+  auto dim_iter = shape.crbegin();
+  for (auto iter = address->rbegin(); iter != address->rend();
+       ++iter, ++dim_iter) {
+    if (++*iter < *dim_iter) return;
+    *iter = 0;
+  }
+}
+
+// Returns the next address, see advance.
 Address increment(Address address, const Shape& shape);
 
+// Walks the addresses of a shape in row-major order.
+//
+// Keeps a counter per dimension and the offset of the address into a strided
+// layout, both updated incrementally, so a step costs no divisions and
+// usually touches only the last dimension.  With the default row-major strides
+// the offset equals index(); loops that only need the flat index of a dense
+// tensor should count it directly and use advance for the address.
+//
+// E.g.
+//   for (Odometer odometer(shape); !odometer.done(); odometer.next()) {
+//     data[odometer.offset()] = fn(odometer.address());
+//   }
+class Odometer {
+ public:
+  using Strides = Shape::Strides;
+
+  // Row-major strides of shape.
+  explicit Odometer(const Shape& shape);
+  Odometer(const Shape& shape, Strides strides);
+
+  const Address& address() const { return address_; }
+
+  // Sum of the address times the strides.
+  size_t offset() const { return offset_; }
+
+  // Number of steps taken.
+  size_t index() const { return index_; }
+
+  bool done() const { return index_ >= size_; }
+
+  void next() {
+    ++index_;
+    for (auto dim = address_.size(); dim-- > 0;) {
+      offset_ += strides_[dim];
+      if (++address_[dim] < dims_[dim]) return;
+      address_[dim] = 0;
+      offset_ -= spans_[dim];
+    }
+  }
+
+ private:
+  std::vector<size_t> dims_;
+  Strides strides_;
+  // Offset covered by a full turn of each dimension.
+  Strides spans_;
+  Address address_;
+  size_t offset_;
+  size_t index_;
+  size_t size_;
+};
+
 }  // Tensor
 
 #endif
@@ -1,20 +1,85 @@
+#include <array>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <unordered_map>
 
 #include "tensor/shape.h"
 
 namespace Alexandria {
 
-Shape::Shape(const Dims& dims) : dims_(dims) {
-  if (!std::all_of(dims_.cbegin(), dims_.cend(),
+namespace {
+// Slots of the per thread cache of entries, a power of two.
+constexpr size_t kCacheSlots = 256;
+
+struct DimsHash {
+  uint64_t operator()(const Shape::Dims& dims) const {
+    return dims.empty() ? 0 : hash64(dims.cbegin(), dims.cend());
+  }
+};
+
+template <typename TValue>
+using DimsMap = std::unordered_map<Shape::Dims, TValue, DimsHash>;
+
+std::mutex& registryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// Owns the entries of all threads.
+template <typename TEntry>
+DimsMap<std::unique_ptr<TEntry>>& registry() {
+  static DimsMap<std::unique_ptr<TEntry>> registry;
+  return registry;
+}
+}  // namespace
+
+Shape::Shape() {
+  static const auto* empty = intern(Dims());
+  entry_ = empty;
+}
+
+Shape::Shape(const Dims& dims) {
+  if (!std::all_of(dims.cbegin(), dims.cend(),
                    [](size_t value) { return value >= 1; })) {
     throw std::invalid_argument("all dimension sizes must be >= 1");
   }
+  entry_ = intern(dims);
+}
+
+auto Shape::intern(const Dims& dims) -> const Entry* {
+  // Most lookups hit the thread's own cache and take no lock.  It is direct
+  // mapped by hash, so it stays small and holds no copies of the dimensions.
+  thread_local std::array<const Entry*, kCacheSlots> cache{};
+  auto& cached = cache[DimsHash()(dims) & (kCacheSlots - 1)];
+  if (cached != nullptr && cached->dims == dims) return cached;
+
+  std::lock_guard<std::mutex> lock(registryMutex());
+  auto& entry = registry<Entry>()[dims];
+  if (!entry) {
+    entry = std::make_unique<Entry>();
+    entry->dims = dims;
+    entry->strides.assign(dims.size(), 1ul);
+    for (auto dim = dims.size(); dim-- > 1;) {
+      entry->strides[dim - 1] = entry->strides[dim] * dims[dim];
+    }
+    entry->n_elements =
+        dims.empty() ? 0 : std::accumulate(dims.cbegin(), dims.cend(), 1ul,
+                                           std::multiplies<size_t>());
+  }
+  cached = entry.get();
+  return cached;
+}
+
+size_t Shape::nInterned() {
+  std::lock_guard<std::mutex> lock(registryMutex());
+  return registry<Entry>().size();
 }
 
-size_t nElements(const Shape& shape) {
-  return shape.nDimensions() == 0 ? 0 : std::accumulate(
-                                            shape.cbegin(), shape.cend(), 1ul,
-                                            std::multiplies<size_t>());
+void Shape::serializeInImpl(ArchiveIn& ar, size_t /*version*/) {
+  Dims dims;
+  ar % dims;
+  entry_ = intern(dims);
 }
 
 std::ostream& operator<<(std::ostream& out, const Shape& s) {
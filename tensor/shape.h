@@ -19,50 +19,80 @@ namespace Alexandria {
 // A tensor has n dimensions.  There are two types of indices.
 // Shape index refers associated with the index associate with dimension.
 // And the address refers a accessing elements.
+//
+// Shapes are interned: all shapes with the same dimensions share one
+// immutable entry holding the dimensions, the row-major strides and the
+// number of elements.  A Shape is a pointer to its entry, so copying is free
+// and equality is pointer equality.  Entries live until the program exits, so
+// memory grows with the number of distinct shapes ever made, e.g. one entry
+// per batch size.  Each thread caches a bounded number of recently used
+// entries.
 
 class Shape : public Serializable {
  public:
   using Dims = std::vector<size_t>;
+  using Strides = std::vector<size_t>;
   using const_iterator = Dims::const_iterator;
   using const_reverse_iterator = Dims::const_reverse_iterator;
 
-  Shape() {}
+  Shape();
   explicit Shape(const Dims& dims);
 
   // Returns the number of dimensions.
-  size_t nDimensions() const { return dims_.size(); }
+  size_t nDimensions() const { return entry_->dims.size(); }
 
   // Returns the size of dimension at dim_index.
-  size_t operator[](size_t index) const { return dims_.at(index); }
+  size_t operator[](size_t index) const { return entry_->dims.at(index); }
+
+  const Dims& dims() const { return entry_->dims; }
+
+  // Row-major strides, the last being 1.
+  const Strides& strides() const { return entry_->strides; }
+
+  // Number of elements, 0 for the shape without dimensions.
+  size_t nElements() const { return entry_->n_elements; }
 
   // Const iterators
-  const_iterator begin() const { return dims_.cbegin(); }
-  const_iterator end() const { return dims_.cend(); }
+  const_iterator begin() const { return entry_->dims.cbegin(); }
+  const_iterator end() const { return entry_->dims.cend(); }
 
-  const_iterator cbegin() const { return dims_.cbegin(); }
-  const_iterator cend() const { return dims_.cend(); }
+  const_iterator cbegin() const { return entry_->dims.cbegin(); }
+  const_iterator cend() const { return entry_->dims.cend(); }
 
   // Const reverse iterators.
-  const_reverse_iterator rbegin() const { return dims_.crbegin(); }
-  const_reverse_iterator rend() const { return dims_.crend(); }
+  const_reverse_iterator rbegin() const { return entry_->dims.crbegin(); }
+  const_reverse_iterator rend() const { return entry_->dims.crend(); }
 
-  const_reverse_iterator crbegin() const { return dims_.crbegin(); }
-  const_reverse_iterator crend() const { return dims_.crend(); }
+  const_reverse_iterator crbegin() const { return entry_->dims.crbegin(); }
+  const_reverse_iterator crend() const { return entry_->dims.crend(); }
+
+  // Number of distinct shapes interned so far.
+  static size_t nInterned();
 
  private:
+  friend bool operator==(const Shape& shape1, const Shape& shape2);
+
+  struct Entry {
+    Dims dims;
+    Strides strides;
+    size_t n_elements;
+  };
+
+  // The entry for dims, created on first use.
+  static const Entry* intern(const Dims& dims);
+
   using ArchiveIn = ArchiveIn;
   using ArchiveOut = ArchiveOut;
-  void serializeInImpl(ArchiveIn& ar, size_t /*version*/) final { ar % dims_; }
-  void serializeOutImpl(ArchiveOut& ar) const final { ar % dims_; }
+  void serializeInImpl(ArchiveIn& ar, size_t /*version*/) final;
+  void serializeOutImpl(ArchiveOut& ar) const final { ar % entry_->dims; }
   size_t serializeOutVersionImpl() const final { return 0ul; }
 
-  Dims dims_;
+  const Entry* entry_;
 };
 
 // Are the two shapes equal?
 inline bool operator==(const Shape& shape1, const Shape& shape2) {
-  return shape1.nDimensions() == shape2.nDimensions() &&
-         std::equal(shape1.cbegin(), shape1.cend(), shape2.cbegin());
+  return shape1.entry_ == shape2.entry_;
 }
 
 // Are the two shapes not equal?
@@ -71,7 +101,7 @@ inline bool operator!=(const Shape& shape1, const Shape& shape2) {
 }
 
 // Calculate the number of elements for the shape.
-size_t nElements(const Shape& shape);
+inline size_t nElements(const Shape& shape) { return shape.nElements(); }
 
 // Streams the shape.
 std::ostream& operator<<(std::ostream& out, const Shape& s);
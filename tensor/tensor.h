@@ -7,5 +7,8 @@
 #include "tensor/tensor_sparse.h"
 #include "tensor/tensor_const_diagonal.h"
 #include "tensor/tensor_const.h"
+#include "tensor/tensor_diagonal.h"
+#include "tensor/tensor_kronecker.h"
+#include "tensor/einsum.h"
 
 #endif
@@ -51,18 +51,24 @@ class Tensor<T>::Const : public Base {
   AddressIterator beginImpl() const {
     return AddressIterator(0ul, Address(this->shape().nDimensions(), 0),
                            &value_, [this](size_t /*index*/, Address& address) {
-                             address =
-                                 increment(std::move(address), this->shape());
+                             advance(&address, shape_);
                              return &value_;
                            });
   }
 
   AddressIterator endImpl() const { return AddressIterator(this->size()); }
 
-  void serializeInImpl(ArchiveIn& ar, size_t /*version*/) final { ar % shape_; }
+  // Version 0 did not store the value, which was always 1.
+  void serializeInImpl(ArchiveIn& ar, size_t version) final {
+    ar % shape_;
+    value_ = 1;
+    if (version >= 1) ar % value_;
+    size_ = std::accumulate(shape_.cbegin(), shape_.cend(), 1ul,
+                            std::multiplies<size_t>());
+  }
 
-  void serializeOutImpl(ArchiveOut& ar) const final { ar % shape_; }
-  size_t serializeOutVersionImpl() const final { return 0ul; }
+  void serializeOutImpl(ArchiveOut& ar) const final { ar % shape_ % value_; }
+  size_t serializeOutVersionImpl() const final { return 1ul; }
 
   std::unique_ptr<Base> cloneImpl() const {
     return std::make_unique<Const>(*this);
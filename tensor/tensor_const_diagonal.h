@@ -67,7 +67,7 @@ class Tensor<T>::ConstDiagonal : public Base {
         [this](size_t /*index*/, Address& address) {
           auto half_address =
               Address(address.cbegin(), address.cbegin() + address.size() / 2);
-          half_address = increment(std::move(half_address), half_shape_);
+          advance(&half_address, half_shape_);
           auto iter = std::copy(half_address.cbegin(), half_address.cend(),
                                 address.begin());
           std::copy(half_address.cbegin(), half_address.cend(), iter);
@@ -77,10 +77,16 @@ class Tensor<T>::ConstDiagonal : public Base {
 
   AddressIterator endImpl() const { return AddressIterator(this->size()); }
 
-  void serializeInImpl(ArchiveIn& ar, size_t /*version*/) final { ar % shape_; }
+  // Version 0 did not store the value, which was always 1.
+  void serializeInImpl(ArchiveIn& ar, size_t version) final {
+    ar % shape_;
+    value_ = 1;
+    if (version >= 1) ar % value_;
+    *this = ConstDiagonal(shape_, value_);
+  }
 
-  void serializeOutImpl(ArchiveOut& ar) const final { ar % shape_; }
-  size_t serializeOutVersionImpl() const final { return 0ul; }
+  void serializeOutImpl(ArchiveOut& ar) const final { ar % shape_ % value_; }
+  size_t serializeOutVersionImpl() const final { return 1ul; }
 
   std::unique_ptr<Base> cloneImpl() const {
     return std::make_unique<ConstDiagonal>(*this);
@@ -8,6 +8,8 @@
 #include "tensor/helpers.h"
 #include "tensor/shape.h"
 #include "tensor/tensor_base.h"
+#include "util/buffer_pool.h"
+#include "util/instrumentation.h"
 #include "util/rng.h"
 #include "util/serializable.h"
 #include "util/util.h"
@@ -23,23 +25,43 @@ namespace Alexandria {
 //
 // Some operations have restrictions on the way data is accessed. This is to
 // make sure the class is used efficiently.
+//
+// The data is drawn from bufferPool(), so temporaries of the same size reuse
+// each other's storage rather than going back to the system allocator.  It is
+// aligned to BufferPool::kAlignment bytes, and large tensors may be backed by
+// huge pages, see BufferPool::setHugePageThreshold.
 template <typename T>
 class Tensor<T>::Dense : public Base {
  public:
-  using Data = std::vector<T>;
+  using Data = std::vector<T, PoolAllocator<T>>;
   using Iterator = typename Data::const_iterator;
 
   Dense() {}
 
   // Construct an uninitialized Tensor<T>::Dense.
   explicit Dense(const Shape& shape)
-      : shape_(shape), accesser_(&shape_), data_(nElements(shape)) {}
+      : shape_(shape), accesser_(&shape_), data_(nElements(shape)) {
+    INSTRUMENT_ALLOCATION("dense allocate", data_.size(),
+                          data_.size() * sizeof(T));
+  }
 
   Dense(const Shape& shape, Data data)
       : shape_(shape), accesser_(&shape_), data_(std::move(data)) {}
 
+  // Copies the data into pooled storage.
+  Dense(const Shape& shape, const std::vector<T>& data)
+      : shape_(shape),
+        accesser_(&shape_),
+        data_(data.cbegin(), data.cend()) {
+    INSTRUMENT_ALLOCATION("dense allocate", data_.size(),
+                          data_.size() * sizeof(T));
+  }
+
   Dense(const Dense& tensor)
-      : shape_(tensor.shape_), accesser_(&shape_), data_(tensor.data_) {}
+      : shape_(tensor.shape_), accesser_(&shape_), data_(tensor.data_) {
+    INSTRUMENT_ALLOCATION("dense allocate", data_.size(),
+                          data_.size() * sizeof(T));
+  }
 
   Dense& operator=(const Dense& tensor) {
     Dense tensor1(tensor);
@@ -82,7 +104,7 @@ class Tensor<T>::Dense : public Base {
     return AddressIterator(
         0ul, Address(shape_.nDimensions(), 0ul), &data_[0],
         [this](size_t index, Address& address) {
-          address = increment(std::move(address), this->shape());
+          advance(&address, shape_);
           return &(data_[index]);
         });
   }
@@ -0,0 +1,96 @@
+#ifndef TENSOR_TENSOR_DIAGONAL_H_
+#define TENSOR_TENSOR_DIAGONAL_H_
+
+#include <memory>
+
+#include "tensor/helpers.h"
+#include "tensor/tensor.h"
+#include "tensor/tensor_base.h"
+
+namespace Alexandria {
+
+// A tensor of eye shape holding a tensor d on its diagonal,
+// D_ab = d_a delta_ab, e.g. the Jacobian of an elementwise function.
+//
+// multiply() contracts a Diagonal as an elementwise scale of the other
+// operand, without visiting its elements.
+template <typename T>
+class Tensor<T>::Diagonal : public Base {
+ public:
+  Diagonal() {}
+
+  explicit Diagonal(const Tensor<T>& diagonal)
+      : shape_(combineShapes(diagonal.shape(), diagonal.shape())),
+        diagonal_(diagonal) {}
+  Diagonal(const Diagonal&) = default;
+  Diagonal& operator=(const Diagonal&) = default;
+
+  virtual ~Diagonal() {}
+
+  // The elements on the diagonal.
+  const Tensor<T>& diagonal() const { return diagonal_; }
+
+ private:
+  size_t sizeImpl() const final { return diagonal_.size(); }
+
+  const Shape& shapeImpl() const final { return shape_; }
+
+  T atImpl(const Address& address) const final {
+    if (address.size() != shape_.nDimensions()) {
+      throw std::invalid_argument("eye address must have even size");
+    }
+    const auto middle = address.cbegin() + address.size() / 2;
+    return std::equal(address.cbegin(), middle, middle)
+               ? diagonal_.at(Address(address.cbegin(), middle))
+               : 0;
+  }
+
+  void setImpl(const Address&, T, std::function<T(T, T)>) final {
+    throw std::invalid_argument("cannot set a diagonal");
+  }
+
+  // Follows the stored elements of the diagonal.
+  AddressIterator beginImpl() const final {
+    auto iter = std::make_shared<AddressIterator>(diagonal_.begin());
+    auto end = diagonal_.end();
+    auto element = [iter, end](Address& address) -> const T* {
+      if (*iter == end) return nullptr;
+      const auto address_value = **iter;
+      address = address_value.first;
+      address.insert(address.end(), address_value.first.cbegin(),
+                     address_value.first.cend());
+      return &address_value.second;
+    };
+
+    Address address;
+    const auto value = element(address);
+    return AddressIterator(0ul, address, value,
+                           [iter, element](size_t /*index*/, Address& address) {
+                             ++*iter;
+                             return element(address);
+                           });
+  }
+
+  AddressIterator endImpl() const final {
+    return AddressIterator(this->size());
+  }
+
+  void serializeInImpl(ArchiveIn& ar, size_t /*version*/) final {
+    ar % diagonal_;
+    shape_ = combineShapes(diagonal_.shape(), diagonal_.shape());
+  }
+
+  void serializeOutImpl(ArchiveOut& ar) const final { ar % diagonal_; }
+  size_t serializeOutVersionImpl() const final { return 0ul; }
+
+  std::unique_ptr<Base> cloneImpl() const {
+    return std::make_unique<Diagonal>(*this);
+  }
+
+  Shape shape_;
+  Tensor<T> diagonal_;
+};
+
+}  // Alexandria
+
+#endif  // TENSOR_TENSOR_DIAGONAL_H_
@@ -0,0 +1,155 @@
+#ifndef TENSOR_TENSOR_KRONECKER_H_
+#define TENSOR_TENSOR_KRONECKER_H_
+
+#include <memory>
+
+#include "tensor/helpers.h"
+#include "tensor/tensor.h"
+#include "tensor/tensor_base.h"
+
+namespace Alexandria {
+
+// The outer product of two tensors kept as its factors,
+//   K_a = F1_a[positions1] F2_a[positions2],
+// where positions give the dimension of the result of each dimension of a
+// factor.  E.g. the Jacobian of a matrix product with respect to one term is
+// an identity times the other term.
+//
+// multiply() contracts a Kronecker as an einsum of its factors, without
+// forming the outer product.
+template <typename T>
+class Tensor<T>::Kronecker : public Base {
+ public:
+  Kronecker() {}
+
+  Kronecker(const Tensor<T>& factor1, const Indices& positions1,
+            const Tensor<T>& factor2, const Indices& positions2)
+      : factor1_(factor1),
+        positions1_(positions1),
+        factor2_(factor2),
+        positions2_(positions2) {
+    initialize();
+  }
+  Kronecker(const Kronecker&) = default;
+  Kronecker& operator=(const Kronecker&) = default;
+
+  virtual ~Kronecker() {}
+
+  const Tensor<T>& factor1() const { return factor1_; }
+  const Indices& positions1() const { return positions1_; }
+  const Tensor<T>& factor2() const { return factor2_; }
+  const Indices& positions2() const { return positions2_; }
+
+ private:
+  // Validates the positions and derives the shape.
+  void initialize() {
+    if (positions1_.size() != factor1_.shape().nDimensions() ||
+        positions2_.size() != factor2_.shape().nDimensions()) {
+      throw std::invalid_argument("one position per factor dimension");
+    }
+    Shape::Dims dims(positions1_.size() + positions2_.size(), 0ul);
+    std::vector<bool> seen(dims.size(), false);
+    auto place = [&dims, &seen](const Tensor<T>& factor,
+                                const Indices& positions) {
+      for (auto index = 0ul; index < positions.size(); ++index) {
+        const auto position = static_cast<size_t>(positions[index]);
+        if (positions[index] < 0 || position >= dims.size() ||
+            seen[position]) {
+          throw std::invalid_argument("positions are not a permutation");
+        }
+        seen[position] = true;
+        dims[position] = factor.shape()[index];
+      }
+    };
+    place(factor1_, positions1_);
+    place(factor2_, positions2_);
+    shape_ = Shape(dims);
+  }
+
+  size_t sizeImpl() const final { return factor1_.size() * factor2_.size(); }
+
+  const Shape& shapeImpl() const final { return shape_; }
+
+  T atImpl(const Address& address) const final {
+    Address address1(positions1_.size());
+    Address address2(positions2_.size());
+    gather(positions1_.cbegin(), positions1_.cend(), address.cbegin(),
+           address1.begin());
+    gather(positions2_.cbegin(), positions2_.cend(), address.cbegin(),
+           address2.begin());
+    return factor1_.at(address1) * factor2_.at(address2);
+  }
+
+  void setImpl(const Address&, T, std::function<T(T, T)>) final {
+    throw std::invalid_argument("cannot set a kronecker product");
+  }
+
+  // Pairs the stored elements of factor2 with each stored element of
+  // factor1, in order.
+  struct Walk {
+    AddressIterator iter1;
+    AddressIterator iter2;
+    T value;
+  };
+
+  AddressIterator beginImpl() const final {
+    if (this->size() == 0) return AddressIterator(0ul);
+    auto walk = std::make_shared<Walk>(
+        Walk{factor1_.begin(), factor2_.begin(), T(0)});
+    const auto n2 = factor2_.size();
+    auto element = [this, walk](Address& address) -> const T* {
+      const auto address_value1 = *walk->iter1;
+      const auto address_value2 = *walk->iter2;
+      address.resize(shape_.nDimensions());
+      scatter(positions1_.cbegin(), positions1_.cend(),
+              address_value1.first.cbegin(), address.begin());
+      scatter(positions2_.cbegin(), positions2_.cend(),
+              address_value2.first.cbegin(), address.begin());
+      walk->value = address_value1.second * address_value2.second;
+      return &walk->value;
+    };
+
+    Address address;
+    const auto value = element(address);
+    return AddressIterator(
+        0ul, address, value,
+        [this, walk, element, n2](size_t index, Address& address) -> const T* {
+          if (index >= this->size()) return nullptr;
+          if (index % n2 == 0) {
+            ++walk->iter1;
+            walk->iter2 = factor2_.begin();
+          } else {
+            ++walk->iter2;
+          }
+          return element(address);
+        });
+  }
+
+  AddressIterator endImpl() const final {
+    return AddressIterator(this->size());
+  }
+
+  void serializeInImpl(ArchiveIn& ar, size_t /*version*/) final {
+    ar % factor1_ % positions1_ % factor2_ % positions2_;
+    initialize();
+  }
+
+  void serializeOutImpl(ArchiveOut& ar) const final {
+    ar % factor1_ % positions1_ % factor2_ % positions2_;
+  }
+  size_t serializeOutVersionImpl() const final { return 0ul; }
+
+  std::unique_ptr<Base> cloneImpl() const {
+    return std::make_unique<Kronecker>(*this);
+  }
+
+  Shape shape_;
+  Tensor<T> factor1_;
+  Indices positions1_;
+  Tensor<T> factor2_;
+  Indices positions2_;
+};
+
+}  // Alexandria
+
+#endif  // TENSOR_TENSOR_KRONECKER_H_
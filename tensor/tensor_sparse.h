@@ -7,6 +7,7 @@
 #include "tensor/address_iterator.h"
 #include "tensor/helpers.h"
 #include "tensor/tensor_base.h"
+#include "util/instrumentation.h"
 #include "util/util.h"
 
 namespace Alexandria {
@@ -37,6 +38,8 @@ class Tensor<T>::Sparse : public Base {
 
   Sparse(const Sparse&) = default;
   Sparse& operator=(const Sparse&) = default;
+  Sparse(Sparse&&) = default;
+  Sparse& operator=(Sparse&&) = default;
 
   virtual ~Sparse() {}
 
@@ -66,6 +69,7 @@ class Tensor<T>::Sparse : public Base {
     if (iter != data_.cend()) {
       iter->second = result;
     } else {
+      INSTRUMENT_REHASH("sparse rehash", data_);
       data_[address] = result;
     }
   }
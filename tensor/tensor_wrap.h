@@ -1,13 +1,21 @@
 #ifndef TENSOR_TENSOR_WRAP_H_
 #define TENSOR_TENSOR_WRAP_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include "tensor/accesser.h"
+#include "tensor/contraction_plan.h"
 #include "tensor/helpers.h"
 #include "tensor/shape.h"
 #include "util/clonable.h"
+#include "util/instrumentation.h"
 #include "util/rng.h"
 #include "util/serializable.h"
 #include "util/util.h"
@@ -31,6 +39,8 @@ class Tensor : public Serializable {
   class Sparse;
   class ConstDiagonal;
   class Const;
+  class Diagonal;
+  class Kronecker;
   class AddressIterator;
 
   using Ptr = std::unique_ptr<Base>;
@@ -51,8 +61,14 @@ class Tensor : public Serializable {
 
   explicit Tensor(const Dense& tensor) : ptr_(tensor.clone()) {}
   explicit Tensor(const Sparse& tensor) : ptr_(tensor.clone()) {}
+  explicit Tensor(Dense&& tensor)
+      : ptr_(std::make_unique<Dense>(std::move(tensor))) {}
+  explicit Tensor(Sparse&& tensor)
+      : ptr_(std::make_unique<Sparse>(std::move(tensor))) {}
   explicit Tensor(const ConstDiagonal& tensor) : ptr_(tensor.clone()) {}
   explicit Tensor(const Const& tensor) : ptr_(tensor.clone()) {}
+  explicit Tensor(const Diagonal& tensor) : ptr_(tensor.clone()) {}
+  explicit Tensor(const Kronecker& tensor) : ptr_(tensor.clone()) {}
 
   explicit Tensor(const Data1d& data)
       : ptr_(Dense(Shape({data.size()}), data).clone()) {}
@@ -68,6 +84,8 @@ class Tensor : public Serializable {
   static Tensor sparse(const Shape& shape);
   static Tensor generate(const Shape& shape, std::function<T(Address)> fn);
   static Tensor constDiagonal(const Shape& shape, T value = 1);
+  // The eye shaped tensor with diagonal on its diagonal.
+  static Tensor diagonal(const Tensor& diagonal);
 
   template <typename TDistribution>
   static Tensor random(const Shape& shape, const TDistribution& distribution);
@@ -128,11 +146,33 @@ class Tensor : public Serializable {
   using ArchiveIn = ArchiveIn;
   using ArchiveOut = ArchiveOut;
 
+  // Storage kind tags written by the versioned archive format.
+  enum StorageKind : uint8_t {
+    kDense = 0,
+    kSparse = 1,
+    kConst = 2,
+    kConstDiagonal = 3,
+    kDiagonal = 4,
+    kKronecker = 5,
+  };
+
+  // Byte order tags.
+  enum ByteOrder : uint8_t { kLittleEndian = 0, kBigEndian = 1 };
+
   Tensor(Ptr ptr) : ptr_(std::move(ptr)) {}
 
-  void serializeInImpl(ArchiveIn& ar, size_t /*version*/) final;
+  // Storage kind of this tensor.
+  StorageKind storageKind() const;
+
+  // Encodes sizeof(T) in the low bits and whether T is floating point or
+  // signed in the high bits.
+  static uint8_t elementType();
+
+  static ByteOrder hostByteOrder();
+
+  void serializeInImpl(ArchiveIn& ar, size_t version) final;
   void serializeOutImpl(ArchiveOut& ar) const final;
-  size_t serializeOutVersionImpl() const final { return 0ul; }
+  size_t serializeOutVersionImpl() const final { return 1ul; }
 
   Ptr ptr_;
 };
@@ -169,6 +209,20 @@ bool operator!=(const Tensor<T>& t1, const Tensor<T>& t2) {
   return !(t1 == t2);
 }
 
+// Name of the storage kind of t, used to label instrumented operations.
+template <typename T>
+std::string storageName(const Tensor<T>& t) {
+  if (t.template isType<typename Tensor<T>::Dense>()) return "dense";
+  if (t.template isType<typename Tensor<T>::Sparse>()) return "sparse";
+  if (t.template isType<typename Tensor<T>::Const>()) return "const";
+  if (t.template isType<typename Tensor<T>::ConstDiagonal>()) {
+    return "const_diagonal";
+  }
+  if (t.template isType<typename Tensor<T>::Diagonal>()) return "diagonal";
+  if (t.template isType<typename Tensor<T>::Kronecker>()) return "kronecker";
+  return "unknown";
+}
+
 template <typename T>
 Tensor<T> Tensor<T>::generate(const Shape& shape,
                               std::function<T(Address)> fn) {
@@ -179,7 +233,7 @@ Tensor<T> Tensor<T>::generate(const Shape& shape,
   Address address(shape.nDimensions(), 0ul);
   for (auto& value : dense.data()) {
     value = fn(address);
-    address = increment(std::move(address), result.shape());
+    advance(&address, shape);
   }
 
   return result;
@@ -200,10 +254,15 @@ Tensor<T> Tensor<T>::constDiagonal(const Shape& shape, T value) {
   return Tensor(ConstDiagonal(shape, value));
 }
 
+template <typename T>
+Tensor<T> Tensor<T>::diagonal(const Tensor& diagonal) {
+  return Tensor(Diagonal(diagonal));
+}
+
 template <typename T>
 Tensor<T>::Tensor(const Data2d& data) {
   Shape shape({data.size(), data.front().size()});
-  std::vector<T> result(nElements(shape));
+  typename Dense::Data result(nElements(shape));
 
   auto index = 0ul;
   for (auto iter1 = data.begin(); iter1 != data.end(); ++iter1) {
@@ -212,13 +271,13 @@ Tensor<T>::Tensor(const Data2d& data) {
       result[index++] = *iter2;
     }
   }
-  ptr_ = Dense(shape, result).clone();
+  ptr_ = std::make_unique<Dense>(shape, std::move(result));
 }
 
 template <typename T>
 Tensor<T>::Tensor(const Data3d& data) {
   Shape shape({data.size(), data.front().size(), data.front().front().size()});
-  std::vector<T> result(nElements(shape));
+  typename Dense::Data result(nElements(shape));
 
   auto index = 0ul;
   for (auto iter1 = data.begin(); iter1 != data.end(); ++iter1) {
@@ -230,7 +289,7 @@ Tensor<T>::Tensor(const Data3d& data) {
       }
     }
   }
-  ptr_ = Dense(shape, result).clone();
+  ptr_ = std::make_unique<Dense>(shape, std::move(result));
 }
 
 // Makes an eye with shape x shape, so that e_ij,lm = delta_il delta_jm
@@ -265,22 +324,89 @@ return result;
 }
 
 template <typename T>
-void Tensor<T>::serializeInImpl(ArchiveIn& ar, size_t /*version*/) {
-  bool isDense = false;
-  ar % isDense;
-  if (isDense) {
-    ptr_ = std::make_unique<Dense>();
-    ar % (*ptr_);
-  } else {
-    ptr_ = std::make_unique<Sparse>();
+auto Tensor<T>::storageKind() const -> StorageKind {
+  if (isType<Dense>()) return kDense;
+  if (isType<Sparse>()) return kSparse;
+  if (isType<Const>()) return kConst;
+  if (isType<ConstDiagonal>()) return kConstDiagonal;
+  if (isType<Diagonal>()) return kDiagonal;
+  if (isType<Kronecker>()) return kKronecker;
+  throw unimplemented_exception("unknown tensor type");
+}
+
+template <typename T>
+uint8_t Tensor<T>::elementType() {
+  static_assert(sizeof(T) < 32, "element type too large to tag");
+  return static_cast<uint8_t>(
+      sizeof(T) | (std::is_floating_point<T>::value ? 0x80 : 0x00) |
+      (std::is_signed<T>::value ? 0x40 : 0x00));
+}
+
+template <typename T>
+auto Tensor<T>::hostByteOrder() -> ByteOrder {
+  const uint16_t probe = 1;
+  return *reinterpret_cast<const uint8_t*>(&probe) == 1 ? kLittleEndian
+                                                         : kBigEndian;
+}
+
+// Version 0 wrote a single isDense flag and loaded everything else as Sparse.
+// Version 1 writes the storage kind, element type and byte order.
+template <typename T>
+void Tensor<T>::serializeInImpl(ArchiveIn& ar, size_t version) {
+  if (version == 0ul) {
+    bool isDense = false;
+    ar % isDense;
+    if (isDense) {
+      ptr_ = std::make_unique<Dense>();
+    } else {
+      ptr_ = std::make_unique<Sparse>();
+    }
     ar % (*ptr_);
+    return;
+  }
+
+  uint8_t kind = 0;
+  uint8_t element_type = 0;
+  uint8_t byte_order = 0;
+  ar % kind % element_type % byte_order;
+
+  if (element_type != elementType()) {
+    throw std::invalid_argument("archived tensor has a different element type");
+  }
+  if (byte_order != hostByteOrder()) {
+    throw unimplemented_exception(
+        "archived tensor has a different byte order");
   }
+
+  switch (kind) {
+    case kDense:
+      ptr_ = std::make_unique<Dense>();
+      break;
+    case kSparse:
+      ptr_ = std::make_unique<Sparse>();
+      break;
+    case kConst:
+      ptr_ = std::make_unique<Const>();
+      break;
+    case kConstDiagonal:
+      ptr_ = std::make_unique<ConstDiagonal>();
+      break;
+    case kDiagonal:
+      ptr_ = std::make_unique<Diagonal>();
+      break;
+    case kKronecker:
+      ptr_ = std::make_unique<Kronecker>();
+      break;
+    default:
+      throw std::invalid_argument("unknown archived tensor storage kind");
+  }
+  ar % (*ptr_);
 }
 
 template <typename T>
 void Tensor<T>::serializeOutImpl(ArchiveOut& ar) const {
-  bool isDense = this->isType<Dense>();
-  ar % isDense % (*ptr_);
+  ar % static_cast<uint8_t>(storageKind()) % elementType() %
+      static_cast<uint8_t>(hostByteOrder()) % (*ptr_);
 }
 
 template <typename T>
@@ -289,7 +415,7 @@ Tensor<T> Tensor<T>::fill(const Shape& shape, T value) {
     return Tensor<T>(Sparse(shape));
   }
 
-  std::vector<T> data(nElements(shape), value);
+  typename Dense::Data data(nElements(shape), value);
   return Tensor<T>(Dense(shape, std::move(data)));
 }
 
@@ -305,13 +431,14 @@ Tensor<T> Tensor<T>::zeros(const Shape& shape) {
 }
 
 // Make a random tensor. TDistribution should be a RandomNumberDistribution
-// concept.
+// concept.  The values are generated straight into the Dense storage.
 template <typename T>
 template <typename TDistribution>
 Tensor<T> Tensor<T>::random(const Shape& shape,
                             const TDistribution& distribution) {
-  auto data = rng().generate(distribution, nElements(shape));
-  return Tensor<T>(Dense(shape, std::move(data)));
+  auto result = Dense(shape);
+  rng().fill(distribution, result.data().begin(), result.data().end());
+  return Tensor<T>(std::move(result));
 }
 
 // Make a uniform(-1, 1) random tensor.
@@ -325,20 +452,21 @@ Tensor<T> Tensor<T>::random(const Shape& shape) {
 template <typename T>
 Tensor<T> apply(Tensor<T> t, std::function<T(T)> fn) {
   using Dense = typename Tensor<T>::Dense;
+  INSTRUMENT_SCOPE("apply " + storageName(t), nElements(t.shape()));
 
   if (t.template isType<Dense>()) {
     auto& temp = t.template reference<Dense>();
     std::transform(temp.data().cbegin(), temp.data().cend(),
                    temp.data().begin(), fn);
   } else {
-    auto result = Tensor<T>(Dense(t.shape()));
+    // The result is dense, so it is written by flat index.
+    auto result = Dense(t.shape());
     Address address(t.shape().nDimensions(), 0);
-    auto size = nElements(t.shape());
-    for (auto index = 0ul; index < size;
-         ++index, address = increment(std::move(address), t.shape())) {
-      result.set(address, fn(t.at(address)));
+    for (auto& value : result.data()) {
+      value = fn(t.at(address));
+      advance(&address, t.shape());
     }
-    std::swap(result, t);
+    t = Tensor<T>(std::move(result));
   }
 
   return t;
@@ -351,6 +479,8 @@ Tensor<T> apply(Tensor<T> t, std::function<T(T)> fn) {
 template <typename T>
 Tensor<T> apply(Tensor<T> t1, const Tensor<T>& t2, std::function<T(T, T)> fn) {
   using Dense = typename Tensor<T>::Dense;
+  INSTRUMENT_SCOPE("apply " + storageName(t1) + "*" + storageName(t2),
+                   nElements(t1.shape()));
 
   if (t1.shape() != t2.shape()) {
     throw std::invalid_argument("shapes are not the same");
@@ -367,18 +497,45 @@ Tensor<T> apply(Tensor<T> t1, const Tensor<T>& t2, std::function<T(T, T)> fn) {
              fn(address_value.second, t2.at(address_value.first)));
     }
   } else {
-    auto result = Tensor<T>(Dense(t1.shape()));
+    auto result = Dense(t1.shape());
     Address address(t1.shape().nDimensions(), 0);
-    auto size = nElements(t1.shape());
-    for (auto index = 0ul; index < size;
-         ++index, address = increment(std::move(address), t1.shape())) {
-      result.set(address, fn(t1.at(address), t2.at(address)));
+    for (auto& value : result.data()) {
+      value = fn(t1.at(address), t2.at(address));
+      advance(&address, t1.shape());
     }
-    std::swap(result, t1);
+    t1 = Tensor<T>(std::move(result));
   }
   return t1;
 }
 
+// Overwrite t with random values, in place if t is Dense.
+template <typename T, typename TDistribution>
+Tensor<T> randomize(Tensor<T> t, const TDistribution& distribution) {
+  using Dense = typename Tensor<T>::Dense;
+
+  if (t.template isType<Dense>()) {
+    auto& temp = t.template reference<Dense>();
+    rng().fill(distribution, temp.data().begin(), temp.data().end());
+    return t;
+  }
+  return Tensor<T>::random(t.shape(), distribution);
+}
+
+// Sample each element as 1 with the probability given by the element of t and
+// 0 otherwise, in place if t is Dense.
+template <typename T>
+Tensor<T> bernoulli(Tensor<T> t) {
+  using Dense = typename Tensor<T>::Dense;
+
+  if (!t.template isType<Dense>()) {
+    t = apply<T>(std::move(t), [](T x) { return x; });
+  }
+  auto& temp = t.template reference<Dense>();
+  rng().bernoulli(temp.data().cbegin(), temp.data().cend(),
+                  temp.data().begin());
+  return t;
+}
+
 template <typename T>
 inline Tensor<T> unaryMinus(Tensor<T> t) {
   return apply<T>(std::move(t), [](T x) { return -x; });
@@ -516,91 +673,332 @@ result_address_iter->cbegin(),
 }
 */
 
+// Relabel the dimensions of t, times scale: dimension d of t is dimension
+// labels[d] of the result.  Dense, Const and Kronecker tensors keep their
+// storage, as do identities and diagonals whose pairs of dimensions stay
+// pairs.  Others become Sparse.
 template <typename T>
-Tensor<T> multiply(const Tensor<T>& t1, const Indices& indices1,
-                   const Tensor<T>& t2, const Indices& indices2) {
+Tensor<T> relabel(const Tensor<T>& t, const Indices& labels, T scale = 1) {
+  using Dense = typename Tensor<T>::Dense;
+  using Sparse = typename Tensor<T>::Sparse;
+  using Const = typename Tensor<T>::Const;
+  using ConstDiagonal = typename Tensor<T>::ConstDiagonal;
+  using Diagonal = typename Tensor<T>::Diagonal;
+  using Kronecker = typename Tensor<T>::Kronecker;
+
+  Shape::Dims dims(labels.size());
+  for (auto index = 0ul; index < labels.size(); ++index) {
+    dims[static_cast<size_t>(labels[index])] = t.shape()[index];
+  }
+  const auto shape = Shape(dims);
+
+  if (t.template isType<Dense>()) {
+    const auto& data = t.template reference<Dense>().data();
+    auto result = Dense(shape);
+    Shape::Strides strides(labels.size());
+    for (auto index = 0ul; index < labels.size(); ++index) {
+      strides[index] = shape.strides()[static_cast<size_t>(labels[index])];
+    }
+    auto value = data.cbegin();
+    for (Odometer odometer(t.shape(), strides); !odometer.done();
+         odometer.next()) {
+      result.data()[odometer.offset()] = scale * *value++;
+    }
+    return Tensor<T>(std::move(result));
+  }
+
+  if (t.template isType<Const>()) {
+    return Tensor<T>(Const(shape, scale * t.at(Address(labels.size(), 0ul))));
+  }
+
+  const auto identity = t.template isType<ConstDiagonal>();
+  if (identity || t.template isType<Diagonal>()) {
+    // Pair k lands on the pair low[k], low[k] + n of the result.
+    const auto n = labels.size() / 2;
+    Indices low(n);
+    auto pairs = true;
+    for (auto pair = 0ul; pair < n && pairs; ++pair) {
+      low[pair] = std::min(labels[pair], labels[n + pair]);
+      pairs = std::max(labels[pair], labels[n + pair]) ==
+              low[pair] + static_cast<int>(n);
+    }
+    if (pairs && identity) {
+      const auto value = t.at(Address(labels.size(), 0ul));
+      return Tensor<T>::constDiagonal(shape, scale * value);
+    }
+    if (pairs) {
+      return Tensor<T>::diagonal(relabel(
+          t.template reference<Diagonal>().diagonal(), low, scale));
+    }
+  }
+
+  if (t.template isType<Kronecker>()) {
+    // Only the positions of the factors move.
+    const auto& kronecker = t.template reference<Kronecker>();
+    auto positions = [&labels](const Indices& factor_positions) {
+      Indices result(factor_positions.size());
+      for (auto index = 0ul; index < result.size(); ++index) {
+        result[index] =
+            labels[static_cast<size_t>(factor_positions[index])];
+      }
+      return result;
+    };
+    Indices labels2(kronecker.positions2().size());
+    std::iota(labels2.begin(), labels2.end(), 0);
+    return Tensor<T>(Kronecker(
+        kronecker.factor1(), positions(kronecker.positions1()),
+        almostEqual(scale, T(1)) ? kronecker.factor2()
+                                 : relabel(kronecker.factor2(), labels2, scale),
+        positions(kronecker.positions2())));
+  }
+
+  auto result = Sparse(shape);
+  Address address(labels.size());
+  for (const auto& address_value : t) {
+    scatter(labels.cbegin(), labels.cend(), address_value.first.cbegin(),
+            address.begin());
+    result.data()[address] = scale * address_value.second;
+  }
+  return Tensor<T>(std::move(result));
+}
+
+// multiply() of an identity (a ConstDiagonal) or a Diagonal t1 with t2 without
+// visiting the elements of t1.  Each pair of dimensions of t1 either
+// - shares a summed index with t2, which renames that dimension of t2,
+// - shares a result index with t2, which puts t2 on the diagonal, or
+// - is not in t2 and stays a diagonal pair of the result.
+// An identity becomes a relabeling of t2, a Diagonal an elementwise scale.
+// Returns false for the other cases, e.g. both dimensions of a pair in t2.
+template <typename T>
+bool multiplyStructured(const Tensor<T>& t1, const Indices& indices1,
+                        const Tensor<T>& t2, const Indices& indices2,
+                        Tensor<T>* result) {
+  using ConstDiagonal = typename Tensor<T>::ConstDiagonal;
+  using Diagonal = typename Tensor<T>::Diagonal;
+  using Kronecker = typename Tensor<T>::Kronecker;
+
+  const auto identity = t1.template isType<ConstDiagonal>();
+  if (!identity && !t1.template isType<Diagonal>()) return false;
+  const auto n = indices1.size() / 2;
+  if (n == 0) return false;
+
+  auto labels2 = indices2;
+  // The label of each pair of t1 not shared with t2.
+  Indices others(n);
+  Indices kept;
+  Shape::Dims kept_dims;
+  Indices diagonal_labels(indices2.size(), invalid_index);
+  auto n_diagonal = 0ul;
+  for (auto pair = 0ul; pair < n; ++pair) {
+    const auto label1 = indices1[pair];
+    const auto label2 = indices1[n + pair];
+    const auto iter1 = std::find(indices2.cbegin(), indices2.cend(), label1);
+    const auto iter2 = std::find(indices2.cbegin(), indices2.cend(), label2);
+    const auto in1 = iter1 != indices2.cend();
+    const auto in2 = iter2 != indices2.cend();
+    if (in1 && in2) return false;
+
+    if (!in1 && !in2) {
+      kept.push_back(label1);
+      kept.push_back(label2);
+      kept_dims.push_back(t1.shape()[pair]);
+      continue;
+    }
+
+    const auto position =
+        static_cast<size_t>((in1 ? iter1 : iter2) - indices2.cbegin());
+    const auto other = in1 ? label2 : label1;
+    others[pair] = other;
+    if (indices2[position] < 0) {
+      labels2[position] = other;
+    } else {
+      // The pair must be dimensions p and p + n of the result, with t2 as
+      // dimension p of the diagonal.
+      const auto low = std::min(indices2[position], other);
+      if (std::max(indices2[position], other) != low + static_cast<int>(n)) {
+        return false;
+      }
+      diagonal_labels[position] = low;
+      ++n_diagonal;
+    }
+  }
+
+  if (n_diagonal > 0 &&
+      (!identity || n_diagonal != n || indices2.size() != n)) {
+    return false;
+  }
+  if (!identity && !kept.empty()) return false;
+
+  INSTRUMENT_SCOPE("multiply " + storageName(t1) + "*" + storageName(t2),
+                   t2.size());
+
+  if (n_diagonal > 0) {
+    // t2 is the diagonal of the result.
+    const auto value = t1.at(Address(indices1.size(), 0ul));
+    *result = Tensor<T>::diagonal(relabel(t2, diagonal_labels, value));
+    return true;
+  }
+
+  if (!identity) {
+    // Scale t2 along the renamed dimensions.
+    *result = multiply(t1.template reference<Diagonal>().diagonal(), others,
+                       t2, labels2);
+    return true;
+  }
+
+  const auto value = t1.at(Address(indices1.size(), 0ul));
+  if (kept.empty()) {
+    *result = relabel(t2, labels2, value);
+    return true;
+  }
+
+  // The pairs not in t2 stay an identity, whose first half is kept[0, 2, ...]
+  // and second half kept[1, 3, ...].
+  Indices positions(kept.size());
+  for (auto pair = 0ul; pair < kept_dims.size(); ++pair) {
+    positions[pair] = kept[2 * pair];
+    positions[kept_dims.size() + pair] = kept[2 * pair + 1];
+  }
+  auto dims = kept_dims;
+  dims.insert(dims.end(), kept_dims.cbegin(), kept_dims.cend());
+  *result = Tensor<T>(Kronecker(Tensor<T>::constDiagonal(Shape(dims), value),
+                                positions, t2, labels2));
+  return true;
+}
+
+// multiply() visiting the stored elements of t1 and t2, whatever their
+// storage.
+template <typename T>
+Tensor<T> multiplyElements(const Tensor<T>& t1, const Indices& indices1,
+                           const Tensor<T>& t2, const Indices& indices2) {
   using namespace Alexandria;
   using namespace std;
 
-  Shape result_shape;
-
-  tie(result_shape, std::ignore) =
-      multiplyShapes(t1.shape(), indices1, t2.shape(), indices2);
+  using Dense = typename Tensor<T>::Dense;
+  using Sparse = typename Tensor<T>::Sparse;
+
+  const auto dense1 = t1.template isType<Dense>();
+  const auto dense2 = t2.template isType<Dense>();
+  const auto plan = contractionPlans()(
+      {t1.shape(), indices1, dense1, t2.shape(), indices2, dense2});
+
+  // Counts the pairs of elements visited.
+  INSTRUMENT_SCOPE("multiply " + storageName(t1) + "*" + storageName(t2),
+                   t1.size() * t2.size());
+
+  if (plan->strided) {
+    auto result = Dense(plan->result_shape);
+    const auto& data1 = t1.template reference<Dense>().data();
+    const auto& data2 = t2.template reference<Dense>().data();
+    Odometer odometer1(plan->loop_shape, plan->loop_strides1);
+    Odometer odometer2(plan->loop_shape, plan->loop_strides2);
+    Odometer odometer_result(plan->loop_shape, plan->loop_strides_result);
+    for (; !odometer1.done();
+         odometer1.next(), odometer2.next(), odometer_result.next()) {
+      result.data()[odometer_result.offset()] +=
+          data1[odometer1.offset()] * data2[odometer2.offset()];
+    }
+    return Tensor<T>(std::move(result));
+  }
 
-  auto result = Tensor<T>::zeros(result_shape);
-  auto result_address = Address(result_shape.nDimensions());
-
-  auto common_indices1 = Indices(indices1.size());
-  auto common_indices2 = Indices(indices2.size());
-
-  // grab common indices.
-  transform(indices1.cbegin(), indices1.cend(), common_indices1.begin(),
-            [&indices2](auto index) {
-              return std::find(indices2.cbegin(), indices2.cend(), index) !=
-                             indices2.cend()
-                         ? index
-                         : invalid_index;
-            });
-
-  transform(indices2.cbegin(), indices2.cend(), common_indices2.begin(),
-            [&indices1](auto index) {
-              return std::find(indices1.cbegin(), indices1.cend(), index) !=
-                             indices1.cend()
-                         ? index
-                         : invalid_index;
-            });
-
-  // reindex in ascending order
-  Indices reindex;
-  copy_if(common_indices1.cbegin(), common_indices1.cend(),
-          back_inserter(reindex),
-          [](auto index) { return index != invalid_index; });
-
-  sort(reindex.begin(), reindex.end());
-
-  transform(common_indices1.cbegin(), common_indices1.cend(),
-            common_indices1.begin(), [&reindex](auto index) {
-              return index == invalid_index
-                         ? invalid_index
-                         : find(reindex.cbegin(), reindex.cend(), index) -
-                               reindex.cbegin();
-            });
-  transform(common_indices2.cbegin(), common_indices2.cend(),
-            common_indices2.begin(), [&reindex](auto index) {
-              return index == invalid_index
-                         ? invalid_index
-                         : find(reindex.cbegin(), reindex.cend(), index) -
-                               reindex.cbegin();
-            });
-
-  auto count = static_cast<size_t>(
-      count_if(common_indices1.cbegin(), common_indices1.cend(),
-               [](auto index) { return index != invalid_index; }));
-
-  auto common_address1 = Address(count);
-  auto common_address2 = Address(count);
+  // Elements of t1 and t2 are paired when they agree on the shared
+  // dimensions, and accumulate into the result in the storage it is expected
+  // to need.
+  auto common_address1 = Address(plan->n_common);
+  auto common_address2 = Address(plan->n_common);
+
+  if (denseResult(*plan, t1.size(), t2.size())) {
+    auto result = Dense(plan->result_shape);
+    auto& data = result.data();
+    for (const auto& address_value1 : t1) {
+      scatter(plan->common_positions1.cbegin(), plan->common_positions1.cend(),
+              address_value1.first.cbegin(), common_address1.begin());
+      const auto offset1 =
+          std::inner_product(address_value1.first.cbegin(),
+                             address_value1.first.cend(),
+                             plan->result_strides1.cbegin(), 0ul);
+      for (const auto& address_value2 : t2) {
+        scatter(plan->common_positions2.cbegin(),
+                plan->common_positions2.cend(), address_value2.first.cbegin(),
+                common_address2.begin());
+
+        if (common_address1 != common_address2) continue;
+
+        data[offset1 + std::inner_product(address_value2.first.cbegin(),
+                                          address_value2.first.cend(),
+                                          plan->result_strides2.cbegin(),
+                                          0ul)] +=
+            address_value1.second * address_value2.second;
+      }
+    }
+    return Tensor<T>(std::move(result));
+  }
 
+  auto result = Sparse(plan->result_shape);
+  auto& data = result.data();
+  auto result_address = Address(plan->result_shape.nDimensions());
   for (const auto& address_value1 : t1) {
-    scatter(common_indices1.cbegin(), common_indices1.cend(),
+    scatter(plan->common_positions1.cbegin(), plan->common_positions1.cend(),
             address_value1.first.cbegin(), common_address1.begin());
-    scatter(indices1.cbegin(), indices1.cend(), address_value1.first.cbegin(),
-            result_address.begin(),
-            [](int index) { return index >= 0 ? index : invalid_index; });
+    scatter(plan->result_positions1.cbegin(), plan->result_positions1.cend(),
+            address_value1.first.cbegin(), result_address.begin());
     for (const auto& address_value2 : t2) {
-      scatter(common_indices2.cbegin(), common_indices2.cend(),
+      scatter(plan->common_positions2.cbegin(), plan->common_positions2.cend(),
               address_value2.first.cbegin(), common_address2.begin());
 
       if (common_address1 != common_address2) continue;
 
-      scatter(indices2.cbegin(), indices2.cend(), address_value2.first.cbegin(),
-              result_address.begin(),
-              [](int index) { return index >= 0 ? index : invalid_index; });
+      scatter(plan->result_positions2.cbegin(), plan->result_positions2.cend(),
+              address_value2.first.cbegin(), result_address.begin());
 
-      result.set(result_address, address_value1.second * address_value2.second,
-                 [](T init, T value) { return init + value; });
+      INSTRUMENT_REHASH("sparse rehash", data);
+      data[result_address] += address_value1.second * address_value2.second;
     }
   }
-  return Tensor<T>(result);
+
+  // Sums that cancelled are not stored, as set() would have dropped them.
+  for (auto iter = data.begin(); iter != data.end();) {
+    iter = almostEqual(iter->second, T(0)) ? data.erase(iter) : std::next(iter);
+  }
+  return Tensor<T>(std::move(result));
+}
+
+// multiply() of t1 and t2 as they are stored: identities and diagonals are
+// contracted algebraically, Kronecker products element by element.  The steps
+// of einsum use it, so that a Kronecker intermediate is not expanded into
+// another einsum.
+template <typename T>
+Tensor<T> multiplyPair(const Tensor<T>& t1, const Indices& indices1,
+                       const Tensor<T>& t2, const Indices& indices2) {
+  Tensor<T> structured;
+  if (multiplyStructured(t1, indices1, t2, indices2, &structured) ||
+      multiplyStructured(t2, indices2, t1, indices1, &structured)) {
+    return structured;
+  }
+  return multiplyElements(t1, indices1, t2, indices2);
+}
+
+template <typename T>
+Tensor<T> multiply(const Tensor<T>& t1, const Indices& indices1,
+                   const Tensor<T>& t2, const Indices& indices2) {
+  using Kronecker = typename Tensor<T>::Kronecker;
+
+  // Structured operands are contracted algebraically.
+  Tensor<T> structured;
+  if (multiplyStructured(t1, indices1, t2, indices2, &structured) ||
+      multiplyStructured(t2, indices2, t1, indices1, &structured)) {
+    return structured;
+  }
+  auto result_index = [](int index) { return index >= 0; };
+  if ((t1.template isType<Kronecker>() || t2.template isType<Kronecker>()) &&
+      (std::any_of(indices1.cbegin(), indices1.cend(), result_index) ||
+       std::any_of(indices2.cbegin(), indices2.cend(), result_index))) {
+    // einsum.h includes this file, so einsum is found by argument dependent
+    // lookup.
+    return einsum(std::vector<const Tensor<T>*>{&t1, &t2},
+                  std::vector<Indices>{indices1, indices2});
+  }
+  return multiplyElements(t1, indices1, t2, indices2);
 }
 
 template <typename T>
@@ -617,7 +1015,7 @@ std::ostream& operator<<(std::ostream& out, const Tensor<T>& t) {
     auto idx_size = nElements(t.shape());
     for (auto index = 0ul; index < idx_size; ++index) {
       out << t[address] << " ";
-      address = increment(std::move(address), t.shape());
+      advance(&address, shape);
     }
     out << "}";
   }
@@ -0,0 +1,145 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include "tensor/contraction_plan.h"
+#include "tensor/tensor.h"
+#include "tensor/test/test_tensors.h"
+
+namespace {
+using T = Alexandria::Tensor<double>;
+using Alexandria::Testing::randomTensor;
+using Alexandria::Testing::toSparse;
+}  // namespace
+
+TEST(ContractionPlan, Plan) {
+  using namespace Alexandria;
+
+  // R_ik = Sum_j S_ij T_jk
+  const auto plan = makeContractionPlan(
+      {Shape({2, 3}), {0, -1}, true, Shape({3, 4}), {-1, 1}, true});
+  EXPECT_EQ(plan.result_shape, Shape({2, 4}));
+  EXPECT_EQ(plan.result_positions1, Indices({0, invalid_index}));
+  EXPECT_EQ(plan.result_positions2, Indices({invalid_index, 1}));
+  EXPECT_EQ(plan.common_positions1, Indices({invalid_index, 0}));
+  EXPECT_EQ(plan.common_positions2, Indices({0, invalid_index}));
+  EXPECT_EQ(plan.n_common, 1ul);
+  EXPECT_EQ(plan.common_extent, 3ul);
+  EXPECT_EQ(plan.result_strides1, Shape::Strides({4, 0}));
+  EXPECT_EQ(plan.result_strides2, Shape::Strides({0, 1}));
+
+  EXPECT_TRUE(plan.strided);
+  EXPECT_EQ(plan.loop_shape, Shape({2, 4, 3}));
+  EXPECT_EQ(plan.loop_strides1, Shape::Strides({3, 0, 1}));
+  EXPECT_EQ(plan.loop_strides2, Shape::Strides({0, 1, 4}));
+  EXPECT_EQ(plan.loop_strides_result, Shape::Strides({4, 1, 0}));
+
+  EXPECT_FALSE(makeContractionPlan({Shape({2, 3}), {0, -1}, false,
+                                    Shape({3, 4}), {-1, 1}, true})
+                   .strided);
+  EXPECT_THROW(makeContractionPlan({Shape({2, 3}), {0, 0}, true, Shape({3, 4}),
+                                    {-1, 1}, true}),
+               std::invalid_argument);
+}
+
+TEST(ContractionPlan, Cache) {
+  using namespace Alexandria;
+
+  const auto t1 = T::fill(Shape({5, 7}), 1.0);
+  const auto t2 = T::fill(Shape({7, 11}), 2.0);
+
+  multiply(t1, {0, -1}, t2, {-1, 1});
+  const auto statistics = contractionPlans().statistics();
+  for (auto count = 0; count < 3; ++count) multiply(t1, {0, -1}, t2, {-1, 1});
+  EXPECT_EQ(contractionPlans().statistics().hits, statistics.hits + 3);
+  EXPECT_EQ(contractionPlans().statistics().misses, statistics.misses);
+
+  // Other storage is another plan.
+  multiply(toSparse(t1), {0, -1}, t2, {-1, 1});
+  EXPECT_EQ(contractionPlans().statistics().misses, statistics.misses + 1);
+}
+
+TEST(ContractionPlan, Strided) {
+  using namespace Alexandria;
+
+  const auto t1 = randomTensor(Shape({2, 3, 4}));
+  const auto t2 = randomTensor(Shape({4, 3, 5}));
+
+  // The strided walk of dense operands matches pairing stored elements.
+  const std::vector<std::pair<Indices, Indices>> indices = {
+      {{0, -1, -2}, {-2, -1, 1}},
+      {{0, 1, -1}, {-1, 1, 2}},
+      {{1, -2, -1}, {-1, -2, 0}},
+      {{0, 1, 2}, {3, 4, 5}},
+      {{2, 1, -1}, {-1, 1, 0}},
+  };
+  for (const auto& index : indices) {
+    const auto strided = multiply(t1, index.first, t2, index.second);
+    EXPECT_TRUE(strided.isType<T::Dense>());
+    EXPECT_EQ(strided, multiply(toSparse(t1), index.first, toSparse(t2),
+                                index.second));
+  }
+}
+
+TEST(ContractionPlan, ResultStorage) {
+  using namespace Alexandria;
+
+  EXPECT_EQ(estimateNnz(100, 10, 0, 50), 0);
+  EXPECT_NEAR(estimateNnz(1e6, 10, 10, 10), 10, 1e-3);
+  EXPECT_NEAR(estimateNnz(100, 1, 100, 100), 100, 1e-3);
+
+  // Outer product of two vectors with one element each.
+  auto e1 = T::sparse(Shape({20}));
+  e1.set({3}, 2.0);
+  auto e2 = T::sparse(Shape({30}));
+  e2.set({4}, 5.0);
+  const auto outer = multiply(e1, {0}, e2, {1});
+  EXPECT_TRUE(outer.isType<T::Sparse>());
+  EXPECT_EQ(outer.size(), 1ul);
+  EXPECT_EQ(outer.at({3, 4}), 10.0);
+
+  // A sparse operand against a dense matrix fills the result.
+  const auto m = randomTensor(Shape({20, 30}));
+  const auto product = multiply(e1, {-1}, m, {-1, 0});
+  EXPECT_TRUE(product.isType<T::Dense>());
+  EXPECT_EQ(product,
+            multiply(T::fill(Shape({20}), 0.0) + e1, {-1}, m, {-1, 0}));
+  EXPECT_EQ(product.at({7}), 2.0 * m.at({3, 7}));
+
+  // Sums that cancel are not stored.
+  auto v = T::sparse(Shape({2}));
+  v.set({0}, 1.0);
+  v.set({1}, 1.0);
+  auto w = T::sparse(Shape({2, 100}));
+  w.set({0, 5}, 1.0);
+  w.set({1, 5}, -1.0);
+  const auto cancelled = multiply(v, {-1}, w, {-1, 0});
+  EXPECT_TRUE(cancelled.isType<T::Sparse>());
+  EXPECT_EQ(cancelled.size(), 0ul);
+}
+
+TEST(ContractionPlan, ChainRuleIndices) {
+  using namespace Alexandria;
+
+  const auto& indices = chainRuleIndices(1, 2, 1);
+  EXPECT_EQ(indices.first, Indices({0, -1, -2}));
+  EXPECT_EQ(indices.second, Indices({-1, -2, 1}));
+  EXPECT_EQ(&chainRuleIndices(1, 2, 1), &indices);
+}
+
+int main(int argc, char** argv) {
+  // Disables elapsed time by default.
+  ::testing::GTEST_FLAG(print_time) = false;
+
+  // This allows the user to override the flag on the command line.
+  ::testing::InitGoogleTest(&argc, argv);
+
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
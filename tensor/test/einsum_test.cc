@@ -0,0 +1,170 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include <random>
+#include <set>
+
+#include "tensor/einsum.h"
+#include "tensor/tensor.h"
+#include "tensor/test/test_tensors.h"
+
+namespace {
+using T = Alexandria::Tensor<double>;
+using Alexandria::Testing::randomIntegers;
+using Alexandria::Testing::toSparse;
+
+Alexandria::EinsumOperand denseOperand(const Alexandria::Shape& shape,
+                                       const Alexandria::Indices& indices) {
+  return {shape, indices, nElements(shape), true, false};
+}
+}  // namespace
+
+TEST(Einsum, Plan) {
+  using namespace Alexandria;
+
+  // R_il = Sum_jk A_ij B_jk C_kl: (A B) C costs 2*50*2 + 2*2*50 while
+  // A (B C) costs 50*2*50 + 2*50*50.
+  const std::vector<EinsumOperand> chain = {
+      denseOperand(Shape({2, 50}), {0, -1}),
+      denseOperand(Shape({50, 2}), {-1, -2}),
+      denseOperand(Shape({2, 50}), {-2, 1})};
+  for (const auto strategy : {EinsumPlan::kGreedy, EinsumPlan::kOptimal}) {
+    const auto plan = planEinsum(chain, strategy);
+    ASSERT_EQ(plan.steps.size(), 2ul);
+    EXPECT_EQ(plan.steps[0], std::make_pair(0ul, 1ul));
+    EXPECT_EQ(std::set<size_t>({plan.steps[1].first, plan.steps[1].second}),
+              std::set<size_t>({2, 3}));
+    EXPECT_EQ(plan.cost, 400);
+  }
+
+  // Sparse operands cost by their stored elements.
+  auto sparse_chain = chain;
+  sparse_chain[1].dense = false;
+  sparse_chain[1].nnz = 1;
+  EXPECT_LT(planEinsum(sparse_chain).cost, planEinsum(chain).cost);
+}
+
+TEST(Einsum, OptimalNoWorseThanGreedy) {
+  using namespace Alexandria;
+
+  std::mt19937 generator(3);
+  std::uniform_int_distribution<size_t> dims(1, 20);
+  for (auto count = 0; count < 20; ++count) {
+    // A chain of matrices R_0n = Sum A_01 A_12 ... A_(n-1)n.
+    std::vector<EinsumOperand> operands;
+    auto dim = dims(generator);
+    for (auto index = 0; index < 6; ++index) {
+      const auto next_dim = dims(generator);
+      operands.push_back(denseOperand(
+          Shape({dim, next_dim}),
+          {index == 0 ? 0 : -index, index == 5 ? 1 : -index - 1}));
+      dim = next_dim;
+    }
+    const auto greedy = planEinsum(operands, EinsumPlan::kGreedy);
+    const auto optimal = planEinsum(operands, EinsumPlan::kOptimal);
+    EXPECT_EQ(greedy.steps.size(), 5ul);
+    EXPECT_EQ(optimal.steps.size(), 5ul);
+    EXPECT_LE(optimal.cost, greedy.cost);
+  }
+}
+
+TEST(Einsum, MatchesMultiply) {
+  using namespace Alexandria;
+
+  std::mt19937 generator(5);
+  const auto a = randomIntegers(Shape({3, 4}), &generator);
+  const auto b = randomIntegers(Shape({4, 5, 2}), &generator);
+  const auto c = randomIntegers(Shape({5, 3}), &generator);
+  const auto d = randomIntegers(Shape({2}), &generator);
+
+  // R_il = Sum_jkm A_ij B_jkm C_kl D_m
+  const auto expected = multiply(
+      multiply(multiply(a, {0, -1}, b, {-1, 1, 2}), {0, -1, 1}, c, {-1, 2}),
+      {0, -1, 1}, d, {-1});
+  for (const auto strategy : {EinsumPlan::kGreedy, EinsumPlan::kOptimal}) {
+    EXPECT_EQ(einsum<double>({&a, &b, &c, &d},
+                             {{0, -1}, {-1, -2, -3}, {-2, 1}, {-3}}, strategy),
+              expected);
+    // The order of the operands does not matter.
+    EXPECT_EQ(einsum<double>({&d, &c, &b, &a},
+                             {{-3}, {-2, 1}, {-1, -2, -3}, {0, -1}}, strategy),
+              expected);
+  }
+
+  const auto sparse_b = toSparse(b);
+  EXPECT_EQ(einsum<double>({&a, &sparse_b, &c, &d},
+                           {{0, -1}, {-1, -2, -3}, {-2, 1}, {-3}}),
+            expected);
+
+  // Result indices out of order, and shared by operands.
+  EXPECT_EQ(einsum<double>({&a, &b, &c}, {{1, -1}, {-1, -2, 0}, {-2, 1}}),
+            multiply(multiply(a, {0, -1}, b, {-1, 1, 2}), {1, -1, 0}, c,
+                     {-1, 1}));
+}
+
+TEST(Einsum, NoScalarIntermediates) {
+  using namespace Alexandria;
+
+  // R_i = A_i Sum_j B_j C_j: contracting B with C first leaves no index.
+  const auto a = T({1.0, 2.0, 3.0});
+  const auto b = T({1.0, 3.0});
+  const auto c = T({2.0, 3.0});
+  for (const auto strategy : {EinsumPlan::kGreedy, EinsumPlan::kOptimal}) {
+    EXPECT_EQ(einsum<double>({&a, &b, &c}, {{0}, {-1}, {-1}}, strategy),
+              T({11.0, 22.0, 33.0}));
+    EXPECT_EQ(einsum<double>({&b, &c, &a}, {{-1}, {-1}, {0}}, strategy),
+              T({11.0, 22.0, 33.0}));
+  }
+}
+
+TEST(Einsum, Permute) {
+  using namespace Alexandria;
+
+  std::mt19937 generator(7);
+  const auto a = randomIntegers(Shape({2, 3, 4}), &generator);
+  const auto permuted = einsum<double>({&a}, {{2, 0, 1}});
+  EXPECT_EQ(permuted.shape(), Shape({3, 4, 2}));
+  EXPECT_EQ(permuted.at(Address({1, 3, 0})), a.at(Address({0, 1, 3})));
+  EXPECT_EQ(permuted.at(Address({2, 0, 1})), a.at(Address({1, 2, 0})));
+}
+
+TEST(Einsum, Invalid) {
+  using namespace Alexandria;
+
+  const auto a = T::fill(Shape({2, 3}), 1.0);
+  const auto b = T::fill(Shape({3, 2}), 1.0);
+  // Mismatched number of indices.
+  EXPECT_THROW(einsum<double>({&a, &b}, {{0, -1}}), std::invalid_argument);
+  EXPECT_THROW(einsum<double>({&a, &b}, {{0}, {-1, 1}}),
+               std::invalid_argument);
+  // Repeated index in an operand.
+  EXPECT_THROW(einsum<double>({&a, &b}, {{0, 0}, {-1, 1}}),
+               std::invalid_argument);
+  // Summed index in one operand only.
+  EXPECT_THROW(einsum<double>({&a, &b}, {{0, -1}, {-2, 1}}),
+               std::invalid_argument);
+  // Dimensions do not agree.
+  EXPECT_THROW(einsum<double>({&a, &b}, {{0, -1}, {1, -1}}),
+               std::invalid_argument);
+  // Result indices with a gap.
+  EXPECT_THROW(einsum<double>({&a, &b}, {{0, -1}, {-1, 2}}),
+               std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+  // Disables elapsed time by default.
+  ::testing::GTEST_FLAG(print_time) = false;
+
+  // This allows the user to override the flag on the command line.
+  ::testing::InitGoogleTest(&argc, argv);
+
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
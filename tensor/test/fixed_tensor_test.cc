@@ -0,0 +1,81 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include "tensor/fixed_tensor.h"
+
+TEST(FixedTensor, FixedShape) {
+  using Shape = Alexandria::FixedShape<2, 3, 4>;
+
+  static_assert(Shape::nDimensions() == 3, "");
+  static_assert(Shape::nElements() == 24, "");
+  static_assert(Shape::stride(0) == 12, "");
+  static_assert(Shape::stride(2) == 1, "");
+  static_assert(Shape::flatIndex(1, 2, 3) == 23, "");
+  EXPECT_EQ(Shape::shape(), Alexandria::Shape({2, 3, 4}));
+}
+
+TEST(FixedTensor, Conversion) {
+  using Alexandria::FixedTensor;
+  using Alexandria::Shape;
+  using T = Alexandria::Tensor<double>;
+
+  const auto t = T({{1, 2, 3}, {4, 5, 6}});
+  const FixedTensor<double, 2, 3> fixed(t);
+  EXPECT_EQ(fixed(0, 2), 3);
+  EXPECT_EQ(fixed(1, 0), 4);
+  EXPECT_EQ(fixed.toTensor(), t);
+
+  // Non-dense storage is read element by element.
+  const FixedTensor<double, 2, 2> eye(T::sparseEye(Shape({2, 2})));
+  using Fixed2x2 = FixedTensor<double, 2, 2>;
+  EXPECT_EQ(eye, Fixed2x2(Fixed2x2::Data({{1, 0, 0, 1}})));
+
+  EXPECT_THROW((FixedTensor<double, 3, 2>(t)), std::invalid_argument);
+}
+
+TEST(FixedTensor, Multiply) {
+  using Alexandria::FixedTensor;
+  using T = Alexandria::Tensor<double>;
+
+  const auto t1 = T({{1, 3, 1}, {1, 4, 2}, {2, 1, 3}});
+  const auto t2 = T({{1, 3, 3}, {2, 4, 2}, {2, 1, 3}});
+  const auto product = multiply(FixedTensor<double, 3, 3>(t1),
+                                FixedTensor<double, 3, 3>(t2));
+  EXPECT_EQ(product.toTensor(), multiply(t1, {0, -1}, t2, {-1, 1}));
+}
+
+TEST(FixedTensor, RankedTensor) {
+  using Alexandria::RankedTensor;
+  using Alexandria::Shape;
+
+  using Ranked = RankedTensor<double, 3>;
+  Ranked ranked(Ranked::Dims({{2, 1, 3}}));
+  EXPECT_EQ(ranked.size(), 6);
+  EXPECT_EQ(ranked.shape(), Shape({2, 1, 3}));
+  ranked(1, 0, 2) = 5;
+  EXPECT_EQ(ranked.data().back(), 5);
+
+  const auto t = ranked.toTensor();
+  EXPECT_EQ(t.at(Alexandria::Address({1, 0, 2})), 5);
+  EXPECT_EQ(Ranked(t).data(), ranked.data());
+
+  EXPECT_THROW((RankedTensor<double, 2>(t)), std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+  // Disables elapsed time by default.
+  ::testing::GTEST_FLAG(print_time) = false;
+
+  // This allows the user to override the flag on the command line.
+  ::testing::InitGoogleTest(&argc, argv);
+
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
@@ -114,6 +114,29 @@ TEST(Helper, increment) {
   EXPECT_EQ(address, std::vector<size_t>({0, 0, 0}));
 }
 
+TEST(Helper, Odometer) {
+  using namespace Alexandria;
+
+  Shape shape({3, 1, 2});
+  Address address(shape.nDimensions(), 0);
+  auto count = 0ul;
+  for (Odometer odometer(shape); !odometer.done(); odometer.next()) {
+    EXPECT_EQ(odometer.address(), address);
+    EXPECT_EQ(odometer.offset(), odometer.index());
+    EXPECT_EQ(odometer.index(), count++);
+    advance(&address, shape);
+  }
+  EXPECT_EQ(count, nElements(shape));
+
+  // Column-major strides of a 2x3 matrix.
+  Odometer transposed(Shape({2, 3}), {1, 2});
+  std::vector<size_t> offsets;
+  for (; !transposed.done(); transposed.next()) {
+    offsets.push_back(transposed.offset());
+  }
+  EXPECT_EQ(offsets, std::vector<size_t>({0, 2, 4, 1, 3, 5}));
+}
+
 
 int main(int argc, char** argv) {
   // Disables elapsed time by default.
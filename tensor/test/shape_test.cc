@@ -8,6 +8,8 @@
 #pragma clang diagnostic pop
 
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include "tensor/shape.h"
 
@@ -29,6 +31,37 @@ TEST(Shape, Basic) {
   EXPECT_THROW(Shape({3, 0, 2}), std::invalid_argument);
 }
 
+TEST(Shape, Interned) {
+  using namespace Alexandria;
+
+  Shape shape({4, 3, 2});
+  EXPECT_EQ(shape.strides(), Shape::Strides({6, 2, 1}));
+  EXPECT_EQ(shape.nElements(), 24ul);
+  EXPECT_EQ(Shape().nElements(), 0ul);
+
+  // Equal shapes share the same entry.
+  const auto n_interned = Shape::nInterned();
+  Shape shape2({4, 3, 2});
+  EXPECT_EQ(&shape2.dims(), &shape.dims());
+  EXPECT_EQ(Shape::nInterned(), n_interned);
+  EXPECT_NE(Shape({4, 3}), shape);
+  EXPECT_EQ(Shape::nInterned(), n_interned + 1);
+
+  // Other threads find the same entries.
+  const Shape::Dims* dims = nullptr;
+  std::thread([&dims] { dims = &Shape({4, 3, 2}).dims(); }).join();
+  EXPECT_EQ(dims, &shape.dims());
+
+  // More shapes than the thread cache holds still find their entries.
+  std::vector<Shape> shapes;
+  for (auto dim = 1ul; dim <= 1000; ++dim) shapes.emplace_back(Shape({dim}));
+  const auto n_many = Shape::nInterned();
+  for (auto dim = 1ul; dim <= 1000; ++dim) {
+    EXPECT_EQ(Shape({dim}), shapes[dim - 1]);
+  }
+  EXPECT_EQ(Shape::nInterned(), n_many);
+}
+
 TEST(Shape, Serialize) {
   using namespace Alexandria;
   using namespace std;
@@ -38,6 +71,7 @@ TEST(Shape, Serialize) {
   Shape shape_out({2, 3, 1, 5});
   ar_out % shape_out;
 
+  ar_out.flush();
   istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
   Shape shape_in({2, 1});
@@ -124,6 +124,7 @@ TEST(Tensor, Serialize) {
   Tensor<double> t3;
   Tensor<double> t4;
 
+  ar_out.flush();
   istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
 
@@ -134,6 +135,45 @@ TEST(Tensor, Serialize) {
   EXPECT_EQ(t2, t4);
 }
 
+TEST(Tensor, SerializeStructured) {
+  using namespace Alexandria;
+  using namespace std;
+  using Const = Tensor<double>::Const;
+  using ConstDiagonal = Tensor<double>::ConstDiagonal;
+
+  auto t1 = Tensor<double>::ones(Shape({1000, 1000}));
+  auto t2 = Tensor<double>::constDiagonal(Shape({1000, 1000}), -2.5);
+
+  ostringstream sout;
+  ArchiveOut ar_out(&sout);
+  ar_out % t1 % t2;
+  ar_out.flush();
+
+  // Only the shapes and values are stored.
+  EXPECT_LT(sout.str().size(), 200ul);
+
+  Tensor<double> t3;
+  Tensor<double> t4;
+
+  istringstream sin(sout.str());
+  ArchiveIn ar_in(&sin);
+  ar_in % t3 % t4;
+
+  EXPECT_TRUE(t3.isType<Const>());
+  EXPECT_TRUE(t4.isType<ConstDiagonal>());
+  EXPECT_EQ(t4.size(), 1000ul);
+  EXPECT_DOUBLE_EQ(t4.at({3, 3}), -2.5);
+  EXPECT_DOUBLE_EQ(t4.at({3, 4}), 0.0);
+  EXPECT_EQ(t1, t3);
+  EXPECT_EQ(t2, t4);
+
+  // Tensors archived with a different element type are rejected.
+  istringstream sin2(sout.str());
+  ArchiveIn ar_in2(&sin2);
+  Tensor<float> t5;
+  EXPECT_THROW(ar_in2 % t5, std::invalid_argument);
+}
+
 int main(int argc, char** argv) {
   // Disables elapsed time by default.
   ::testing::GTEST_FLAG(print_time) = false;
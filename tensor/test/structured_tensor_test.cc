@@ -0,0 +1,174 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include <sstream>
+
+#include "tensor/tensor.h"
+#include "tensor/test/test_tensors.h"
+
+namespace {
+using T = Alexandria::Tensor<double>;
+using Alexandria::Testing::randomTensor;
+using Alexandria::Testing::toSparse;
+}  // namespace
+
+TEST(StructuredTensor, Identity) {
+  using namespace Alexandria;
+
+  const auto eye = T::constDiagonal(Shape({3, 4, 3, 4}), 2.0);
+  const auto x = randomTensor(Shape({3, 4, 5}));
+
+  // Summed pairs rename the dimensions of x.
+  const std::vector<std::pair<Indices, Indices>> renames = {
+      {{-1, -2, 0, 1}, {-1, -2, 2}},
+      {{0, 1, -1, -2}, {-1, -2, 2}},
+      {{1, 0, -1, -2}, {-1, -2, 2}}};
+  for (const auto& indices : renames) {
+    const auto result = multiply(eye, indices.first, x, indices.second);
+    EXPECT_TRUE(result.isType<T::Dense>());
+    EXPECT_EQ(result,
+              multiply(toSparse(eye), indices.first, x, indices.second));
+    EXPECT_EQ(multiply(x, indices.second, eye, indices.first), result);
+  }
+
+  // Sparse operands stay sparse.
+  const auto sparse = toSparse(x);
+  const auto result = multiply(eye, {-1, -2, 0, 1}, sparse, {-1, -2, 2});
+  EXPECT_TRUE(result.isType<T::Sparse>());
+  EXPECT_EQ(result, multiply(toSparse(eye), {-1, -2, 0, 1}, x, {-1, -2, 2}));
+
+  // Pairs with both dimensions in x are contracted element by element.
+  const auto eye3 = T::constDiagonal(Shape({3, 3}));
+  const auto y = randomTensor(Shape({3, 3, 5}));
+  const auto trace = multiply(eye3, {-1, -2}, y, {-1, -2, 0});
+  EXPECT_EQ(trace, multiply(toSparse(eye3), {-1, -2}, y, {-1, -2, 0}));
+}
+
+TEST(StructuredTensor, Diagonal) {
+  using namespace Alexandria;
+
+  // Result pairs put x on the diagonal, e.g. the Jacobian of an elementwise
+  // function.
+  const auto eye = T::constDiagonal(Shape({3, 4, 3, 4}));
+  const auto x = randomTensor(Shape({3, 4}));
+  const auto diagonal = multiply(eye, {0, 1, 2, 3}, x, {0, 1});
+  ASSERT_TRUE(diagonal.isType<T::Diagonal>());
+  EXPECT_EQ(diagonal.size(), 12ul);
+  EXPECT_EQ(diagonal.at({1, 2, 1, 2}), x.at({1, 2}));
+  EXPECT_EQ(diagonal.at({1, 2, 1, 3}), 0.0);
+  EXPECT_EQ(diagonal, multiply(toSparse(eye), {0, 1, 2, 3}, x, {0, 1}));
+  EXPECT_EQ(toSparse(diagonal), diagonal);
+
+  // Contracting a diagonal scales the other operand.
+  const auto y = randomTensor(Shape({3, 4, 5}));
+  const auto scaled = multiply(diagonal, {0, 1, -1, -2}, y, {-1, -2, 2});
+  EXPECT_TRUE(scaled.isType<T::Dense>());
+  EXPECT_EQ(scaled,
+            multiply(toSparse(diagonal), {0, 1, -1, -2}, y, {-1, -2, 2}));
+  EXPECT_EQ(multiply(y, {-1, -2, 2}, diagonal, {-1, -2, 0, 1}),
+            multiply(toSparse(diagonal), {-1, -2, 0, 1}, y, {-1, -2, 2}));
+}
+
+TEST(StructuredTensor, Kronecker) {
+  using namespace Alexandria;
+
+  // d(A B)_ik / dA_jl = delta_ij B_lk is an identity times B.
+  const auto eye = T::constDiagonal(Shape({2, 2}));
+  const auto b = randomTensor(Shape({3, 4}));
+  const auto eye4 = T::constDiagonal(Shape({2, 3, 2, 3}));
+  const auto kronecker = multiply(eye4, {0, -1, 2, 3}, b, {-1, 1});
+  ASSERT_TRUE(kronecker.isType<T::Kronecker>());
+  EXPECT_EQ(kronecker.shape(), Shape({2, 4, 2, 3}));
+  EXPECT_EQ(kronecker.size(), 2 * 12ul);
+  EXPECT_EQ(kronecker, multiply(toSparse(eye4), {0, -1, 2, 3}, b, {-1, 1}));
+  EXPECT_EQ(toSparse(kronecker), kronecker);
+
+  // Chain rule contraction with the derivative of A.
+  const auto da = randomTensor(Shape({2, 3, 5}));
+  const auto chain = multiply(kronecker, {0, 1, -1, -2}, da, {-1, -2, 2});
+  EXPECT_EQ(chain,
+            multiply(toSparse(kronecker), {0, 1, -1, -2}, da, {-1, -2, 2}));
+
+  EXPECT_THROW(T(T::Kronecker(eye, {0, 1}, b, {1, 2})), std::invalid_argument);
+}
+
+TEST(StructuredTensor, KroneckerFactorSummed) {
+  using namespace Alexandria;
+
+  // A factor summed away completely against the other operand.
+  const auto u = T({1.0, 2.0, 3.0});
+  const auto w = T::fill(Shape({1}), 2.0);
+  const auto uw = T(T::Kronecker(u, {0}, w, {1}));
+  const auto x = T::fill(Shape({1}), 5.0);
+  EXPECT_EQ(multiply(uw, {0, -1}, x, {-1}), T({10.0, 20.0, 30.0}));
+
+  struct Case {
+    Indices indices1;
+    Shape shape2;
+    Indices indices2;
+  };
+  const auto ab = T(T::Kronecker(randomTensor(Shape({2, 3})), {0, 1},
+                                 randomTensor(Shape({4, 3})), {2, 3}));
+  const std::vector<Case> cases = {
+      {{0, 1, -1, -2}, Shape({4, 3}), {-1, -2}},
+      {{-1, -2, 0, 1}, Shape({2, 3}), {-1, -2}},
+      {{0, -1, -2, -3}, Shape({3, 4, 3}), {-1, -2, -3}},
+      {{-1, -2, -3, -4}, Shape({2, 3, 4, 3, 2}), {-1, -2, -3, -4, 0}}};
+  for (const auto& c : cases) {
+    const auto y = randomTensor(c.shape2);
+    EXPECT_EQ(multiply(ab, c.indices1, y, c.indices2),
+              multiply(toSparse(ab), c.indices1, y, c.indices2));
+  }
+
+  // The identity pair kept by the first einsum step leaves a Kronecker
+  // intermediate, which is not expanded into another einsum.
+  const auto ef = T(T::Kronecker(randomTensor(Shape({2})), {1},
+                                 randomTensor(Shape({1, 3})), {2, 0}));
+  const auto eye = T::constDiagonal(Shape({1, 1}));
+  EXPECT_EQ(multiply(ef, {0, 2, 1}, eye, {3, 1}),
+            multiply(toSparse(ef), {0, 2, 1}, eye, {3, 1}));
+}
+
+TEST(StructuredTensor, Serialize) {
+  using namespace Alexandria;
+
+  const auto diagonal = T::diagonal(randomTensor(Shape({3, 4})));
+  const auto kronecker =
+      T(T::Kronecker(T::constDiagonal(Shape({2, 2}), 3.0), {0, 3},
+                     randomTensor(Shape({4, 5})), {2, 1}));
+
+  std::ostringstream sout;
+  ArchiveOut ar_out(&sout);
+  ar_out % diagonal % kronecker;
+  ar_out.flush();
+
+  T diagonal2;
+  T kronecker2;
+  std::istringstream sin(sout.str());
+  ArchiveIn ar_in(&sin);
+  ar_in % diagonal2 % kronecker2;
+
+  EXPECT_TRUE(diagonal2.isType<T::Diagonal>());
+  EXPECT_TRUE(kronecker2.isType<T::Kronecker>());
+  EXPECT_EQ(diagonal2, diagonal);
+  EXPECT_EQ(kronecker2.shape(), Shape({2, 5, 4, 2}));
+  EXPECT_EQ(kronecker2, kronecker);
+}
+
+int main(int argc, char** argv) {
+  // Disables elapsed time by default.
+  ::testing::GTEST_FLAG(print_time) = false;
+
+  // This allows the user to override the flag on the command line.
+  ::testing::InitGoogleTest(&argc, argv);
+
+  google::InstallFailureSignalHandler();
+
+  return RUN_ALL_TESTS();
+}
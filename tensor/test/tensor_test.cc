@@ -169,6 +169,7 @@ TEST(Tensor, Serialize) {
 
   ar_out % vec;
 
+  ar_out.flush();
   istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
 
@@ -188,6 +189,65 @@ TEST(Tensor, Serialize) {
   EXPECT_TRUE(std::equal(vec.cbegin(), vec.cend(), vec2.cbegin()));
 }
 
+TEST(Tensor, PooledStorage) {
+  using namespace Alexandria;
+  using namespace std;
+
+  bufferPool().clear();
+  bufferPool().resetStatistics();
+
+  const auto shape = Shape({20, 30});
+  const auto weights = Tensor<double>::fill(shape, 0.5);
+  auto misses = 0ul;
+  for (auto iteration = 0; iteration < 5; ++iteration) {
+    auto t1 = Tensor<double>::dense(shape);
+    auto t2 = apply<double>(weights, [](double x) { return 2 * x; }) + t1;
+    auto t3 = t2 - weights;
+    if (iteration == 0) misses = bufferPool().statistics().misses;
+  }
+
+  // Temporaries reuse the storage released by the previous iteration.
+  EXPECT_EQ(bufferPool().statistics().misses, misses);
+}
+
+TEST(Tensor, Random) {
+  using namespace Alexandria;
+  using namespace std;
+
+  const auto shape = Shape({100, 100});
+
+  rng().seed(3);
+  auto t1 = Tensor<double>::random(shape);
+  rng().seed(3);
+  auto t2 = Tensor<double>::random(shape);
+  EXPECT_EQ(t1, t2);
+  EXPECT_TRUE(t1.isType<Tensor<double>::Dense>());
+  for (const auto& address_value : t1) {
+    EXPECT_GE(address_value.second, -1.0);
+    EXPECT_LT(address_value.second, 1.0);
+  }
+
+  // Dense tensors are filled in place.
+  auto t3 = randomize(t1, uniform_real_distribution<double>(2, 3));
+  EXPECT_EQ(t3.shape(), shape);
+  for (const auto& address_value : t3) {
+    EXPECT_GE(address_value.second, 2.0);
+    EXPECT_LT(address_value.second, 3.0);
+  }
+
+  auto zeros = bernoulli(Tensor<double>::zeros(shape));
+  auto ones = bernoulli(Tensor<double>::ones(shape));
+  auto samples = bernoulli(Tensor<double>::fill(shape, 0.25));
+  auto count = 0.0;
+  for (const auto& address_value : samples) {
+    EXPECT_TRUE(address_value.second == 0.0 || address_value.second == 1.0);
+    count += address_value.second;
+  }
+  EXPECT_EQ(zeros, Tensor<double>::zeros(shape));
+  EXPECT_EQ(ones, Tensor<double>::ones(shape));
+  EXPECT_NEAR(count / nElements(shape), 0.25, 0.02);
+}
+
 int main(int argc, char** argv) {
   // Disables elapsed time by default.
   ::testing::GTEST_FLAG(print_time) = false;
@@ -0,0 +1,41 @@
+#ifndef TENSOR_TEST_TEST_TENSORS_H_
+#define TENSOR_TEST_TEST_TENSORS_H_
+
+#include <random>
+
+#include "tensor/tensor.h"
+
+namespace Alexandria {
+namespace Testing {
+
+// A copy of t with sparse storage, which multiply() contracts element by
+// element.
+template <typename T>
+Tensor<T> toSparse(const Tensor<T>& t) {
+  auto result = Tensor<T>::sparse(t.shape());
+  for (const auto& address_value : t) {
+    result.set(address_value.first, address_value.second);
+  }
+  return result;
+}
+
+// Dense tensor with uniform(-1, 1) values.
+template <typename T = double>
+Tensor<T> randomTensor(const Shape& shape) {
+  std::uniform_real_distribution<T> distribution(-1, 1);
+  return Tensor<T>::random(shape, distribution);
+}
+
+// Dense tensor of small integers, so that sums do not depend on their order.
+template <typename T = double>
+Tensor<T> randomIntegers(const Shape& shape, std::mt19937* generator) {
+  std::uniform_int_distribution<int> distribution(-3, 3);
+  return Tensor<T>::generate(shape, [&](const Address&) {
+    return static_cast<T>(distribution(*generator));
+  });
+}
+
+}  // namespace Testing
+}  // namespace Alexandria
+
+#endif  // TENSOR_TEST_TEST_TENSORS_H_
@@ -1,7 +1,50 @@
 #include "util/archive_in.h"
 
+#include <unistd.h>
+
+#include <cerrno>
+
 namespace Alexandria {
 
+constexpr size_t ArchiveIn::kDefaultBufferSize;
+
+ArchiveIn::ArchiveIn(std::istream* stream, size_t buffer_size)
+    : stream_(stream),
+      fd_(-1),
+      buffer_(new char[std::max(buffer_size, 1ul)]),
+      buffer_size_(std::max(buffer_size, 1ul)),
+      position_(0ul),
+      end_(0ul) {}
+
+ArchiveIn::ArchiveIn(int fd, size_t buffer_size)
+    : stream_(nullptr),
+      fd_(fd),
+      buffer_(new char[std::max(buffer_size, 1ul)]),
+      buffer_size_(std::max(buffer_size, 1ul)),
+      position_(0ul),
+      end_(0ul) {
+  if (fd_ < 0) throw std::invalid_argument("invalid file descriptor");
+}
+
+size_t ArchiveIn::readThrough(char* data, size_t size) {
+  if (stream_ != nullptr) {
+    stream_->read(data, static_cast<std::streamsize>(size));
+    return static_cast<size_t>(stream_->gcount());
+  }
+
+  auto total = 0ul;
+  while (total < size) {
+    const auto count = ::read(fd_, data + total, size - total);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("unable to read archive");
+    }
+    if (count == 0) break;
+    total += static_cast<size_t>(count);
+  }
+  return total;
+}
+
 template <>
 ArchiveIn& ArchiveIn::operator%(bool& value) {
   readPrimitive(value);
@@ -86,7 +129,7 @@ ArchiveIn& ArchiveIn::operator%(std::string& value) {
   (*this) % size;
 
   value.resize(size);
-  stream_->read(&value[0], static_cast<long>(size));
+  if (size > 0ul) readBytes(&value[0], size);
   return *this;
 }
 
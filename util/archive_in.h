@@ -1,20 +1,43 @@
 #ifndef UTIL_ARCHIVE_IN_H_
 #define UTIL_ARCHIVE_IN_H_
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 namespace Alexandria {
 
-/* Archive class for serialisation. */
+/* Archive class for serialisation.
+ *
+ * Input is read from the underlying stream (or file descriptor) in bulk into
+ * an internal buffer.  The archive may read ahead of what has been
+ * deserialized, so the stream should not be read directly while the archive
+ * is in use.
+ */
 class ArchiveIn {
  public:
-  explicit ArchiveIn(std::istream* stream) : stream_(stream) {}
+  static constexpr size_t kDefaultBufferSize = 4ul << 20;
+
+  explicit ArchiveIn(std::istream* stream,
+                     size_t buffer_size = kDefaultBufferSize);
+
+  // Read directly from a file descriptor, bypassing iostreams.  The descriptor
+  // is not closed by the archive.
+  explicit ArchiveIn(int fd, size_t buffer_size = kDefaultBufferSize);
+
+  ArchiveIn(const ArchiveIn&) = delete;
+  ArchiveIn& operator=(const ArchiveIn&) = delete;
+
   ~ArchiveIn() {}
 
   // Serialize primitives and generic classes.
@@ -30,8 +53,8 @@ class ArchiveIn {
   ArchiveIn& operator%(std::array<TValue, size>& container);
 
   // Serialize std::vector.
-  template <typename TValue>
-  ArchiveIn& operator%(std::vector<TValue>& container);
+  template <typename TValue, typename TAllocator>
+  ArchiveIn& operator%(std::vector<TValue, TAllocator>& container);
 
   // Serialize std::unordered_set.
   template <typename TValue, typename THash, typename TEqual>
@@ -53,7 +76,25 @@ class ArchiveIn {
   template <typename T>
   void readPrimitive(T& value);
 
+  // Vectors of arithmetic values are read as one block.
+  template <typename TVector>
+  void readVector(TVector& container, std::true_type);
+  template <typename TVector>
+  void readVector(TVector& container, std::false_type);
+
+  // Copy bytes out of the buffer, refilling it when exhausted.
+  void readBytes(char* data, size_t size);
+
+  // Read up to size bytes from the stream or file descriptor. Returns the
+  // number of bytes read.
+  size_t readThrough(char* data, size_t size);
+
   std::istream* stream_;
+  int fd_;
+  std::unique_ptr<char[]> buffer_;
+  size_t buffer_size_;
+  size_t position_;
+  size_t end_;
 };
 
 // Convenience function to serialize value containers.
@@ -86,9 +127,54 @@ ArchiveIn& ArchiveIn::operator%(T& value) {
 
 template <typename T>
 void ArchiveIn::readPrimitive(T& value) {
-  static char temp[sizeof(T)];
-  stream_->read(temp, sizeof(T));
-  value = *reinterpret_cast<T*>(temp);
+  readBytes(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+inline void ArchiveIn::readBytes(char* data, size_t size) {
+  if (size <= end_ - position_) {
+    std::memcpy(data, buffer_.get() + position_, size);
+    position_ += size;
+    return;
+  }
+
+  const auto available = end_ - position_;
+  std::memcpy(data, buffer_.get() + position_, available);
+  data += available;
+  size -= available;
+  position_ = end_ = 0ul;
+
+  if (size >= buffer_size_) {
+    if (readThrough(data, size) != size) {
+      throw std::runtime_error("unexpected end of archive");
+    }
+    return;
+  }
+
+  end_ = readThrough(buffer_.get(), buffer_size_);
+  if (end_ < size) throw std::runtime_error("unexpected end of archive");
+  std::memcpy(data, buffer_.get(), size);
+  position_ = size;
+}
+
+template <typename TVector>
+void ArchiveIn::readVector(TVector& container, std::true_type) {
+  auto size = 0ul;
+  (*this) % size;
+  container.resize(size);
+  if (size == 0ul) return;
+  readBytes(reinterpret_cast<char*>(container.data()),
+            size * sizeof(typename TVector::value_type));
+}
+
+template <typename TVector>
+void ArchiveIn::readVector(TVector& container, std::false_type) {
+  using ValueType = typename TVector::value_type;
+
+  serializeInContainer<TVector, ValueType>(
+      *this,
+      [&container](const ValueType& value) { container.emplace_back(value); },
+      [&container]() { container.clear(); },
+      [&container](size_t size) { container.reserve(size); });
 }
 
 template <typename TFirst, typename TSecond>
@@ -108,16 +194,14 @@ ArchiveIn& ArchiveIn::operator%(std::array<TValue, size>& container) {
       []() {});
 }
 
-template <typename TValue>
-ArchiveIn& ArchiveIn::operator%(std::vector<TValue>& container) {
-  using ContainerType = std::vector<TValue>;
-  using ValueType = typename ContainerType::value_type;
-
-  return serializeInContainer<ContainerType, ValueType>(
-      *this,
-      [&container](const TValue& value) { container.emplace_back(value); },
-      [&container]() { container.clear(); },
-      [&container](size_t size) { container.reserve(size); });
+template <typename TValue, typename TAllocator>
+ArchiveIn& ArchiveIn::operator%(std::vector<TValue, TAllocator>& container) {
+  // std::vector<bool> is not contiguous.
+  using IsBlock = std::integral_constant<
+      bool, std::is_arithmetic<TValue>::value &&
+                !std::is_same<TValue, bool>::value>;
+  readVector(container, IsBlock());
+  return *this;
 }
 
 template <typename TValue, typename THash, typename TEqual>
@@ -1,7 +1,63 @@
 #include "util/archive_out.h"
 
+#include <unistd.h>
+
+#include <cerrno>
+
 namespace Alexandria {
 
+constexpr size_t ArchiveOut::kDefaultBufferSize;
+
+ArchiveOut::ArchiveOut(std::ostream* stream, size_t buffer_size)
+    : stream_(stream),
+      fd_(-1),
+      buffer_(new char[std::max(buffer_size, 1ul)]),
+      buffer_size_(std::max(buffer_size, 1ul)),
+      position_(0ul) {}
+
+ArchiveOut::ArchiveOut(int fd, size_t buffer_size)
+    : stream_(nullptr),
+      fd_(fd),
+      buffer_(new char[std::max(buffer_size, 1ul)]),
+      buffer_size_(std::max(buffer_size, 1ul)),
+      position_(0ul) {
+  if (fd_ < 0) throw std::invalid_argument("invalid file descriptor");
+}
+
+ArchiveOut::~ArchiveOut() {
+  // Destructors cannot report failures; call flush() explicitly to check.
+  writeThrough(buffer_.get(), position_);
+}
+
+void ArchiveOut::flush() {
+  const auto size = position_;
+  position_ = 0ul;
+  if (!writeThrough(buffer_.get(), size)) {
+    throw std::runtime_error("unable to write archive");
+  }
+  if (stream_ != nullptr) stream_->flush();
+}
+
+bool ArchiveOut::writeThrough(const char* data, size_t size) {
+  if (size == 0ul) return true;
+
+  if (stream_ != nullptr) {
+    stream_->write(data, static_cast<std::streamsize>(size));
+    return stream_->good();
+  }
+
+  while (size > 0ul) {
+    const auto written = ::write(fd_, data, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
 template <>
 ArchiveOut& ArchiveOut::operator%(const bool& value) {
   writePrimitive(value);
@@ -83,8 +139,7 @@ ArchiveOut& ArchiveOut::operator%(const long double& value) {
 template <>
 ArchiveOut& ArchiveOut::operator%(const std::string& value) {
   (*this) % value.size();
-  stream_->write(reinterpret_cast<const char*>(&value[0]),
-                 static_cast<long>(value.size()));
+  writeBytes(value.data(), value.size());
   return *this;
 }
 
@@ -1,21 +1,46 @@
 #ifndef UTIL_ARCHIVE_OUT_H_
 #define UTIL_ARCHIVE_OUT_H_
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 namespace Alexandria {
 
-/* Archive class for serialisation. */
+/* Archive class for serialisation.
+ *
+ * Output is staged in an internal buffer and written to the underlying stream
+ * (or file descriptor) in bulk.  Nothing reaches the stream until flush() is
+ * called or the archive is destroyed, so call flush() before reading back
+ * what has been written while the archive is still alive.
+ */
 class ArchiveOut {
  public:
-  explicit ArchiveOut(std::ostream* stream) : stream_(stream) {}
-  ~ArchiveOut() {}
+  static constexpr size_t kDefaultBufferSize = 4ul << 20;
+
+  explicit ArchiveOut(std::ostream* stream,
+                      size_t buffer_size = kDefaultBufferSize);
+
+  // Write directly to a file descriptor, bypassing iostreams.  The descriptor
+  // is not closed by the archive.
+  explicit ArchiveOut(int fd, size_t buffer_size = kDefaultBufferSize);
+
+  ArchiveOut(const ArchiveOut&) = delete;
+  ArchiveOut& operator=(const ArchiveOut&) = delete;
+
+  ~ArchiveOut();
+
+  // Write the buffered data out to the stream or file descriptor.
+  void flush();
 
   // Serialize primitives and generic classes.
   template <typename T>
@@ -30,8 +55,8 @@ class ArchiveOut {
   ArchiveOut& operator%(const std::array<TValue, n>& value);
 
   // Serialize std::vector.
-  template <typename TValue>
-  ArchiveOut& operator%(const std::vector<TValue>& value);
+  template <typename TValue, typename TAllocator>
+  ArchiveOut& operator%(const std::vector<TValue, TAllocator>& value);
 
   // Serialize std::unordered_set.
   template <typename TValue, typename THash, typename TEqual>
@@ -50,11 +75,27 @@ class ArchiveOut {
   // Note: other standard containers to be added as necessary.
 
  private:
-  // Convenient private function for reading primitives.
+  // Convenient private function for writing primitives.
   template <typename T>
   void writePrimitive(const T& value);
 
+  // Vectors of arithmetic values are written as one block.
+  template <typename TVector>
+  void writeVector(const TVector& container, std::true_type);
+  template <typename TVector>
+  void writeVector(const TVector& container, std::false_type);
+
+  // Stage bytes in the buffer, flushing it when full.
+  void writeBytes(const char* data, size_t size);
+
+  // Write bytes to the stream or file descriptor. Returns false on failure.
+  bool writeThrough(const char* data, size_t size);
+
   std::ostream* stream_;
+  int fd_;
+  std::unique_ptr<char[]> buffer_;
+  size_t buffer_size_;
+  size_t position_;
 };
 
 template <typename TContainer>
@@ -76,7 +117,34 @@ ArchiveOut& ArchiveOut::operator%(const T& value) {
 
 template <typename T>
 void ArchiveOut::writePrimitive(const T& value) {
-  stream_->write(reinterpret_cast<const char*>(&value), sizeof(T));
+  writeBytes(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+inline void ArchiveOut::writeBytes(const char* data, size_t size) {
+  if (size > buffer_size_ - position_) {
+    flush();
+    if (size >= buffer_size_) {
+      if (!writeThrough(data, size)) {
+        throw std::runtime_error("unable to write archive");
+      }
+      return;
+    }
+  }
+  std::memcpy(buffer_.get() + position_, data, size);
+  position_ += size;
+}
+
+template <typename TVector>
+void ArchiveOut::writeVector(const TVector& container, std::true_type) {
+  (*this) % container.size();
+  if (container.empty()) return;
+  writeBytes(reinterpret_cast<const char*>(container.data()),
+             container.size() * sizeof(typename TVector::value_type));
+}
+
+template <typename TVector>
+void ArchiveOut::writeVector(const TVector& container, std::false_type) {
+  serializeOutContainer(*this, container);
 }
 
 template <typename TFirst, typename TSecond>
@@ -89,9 +157,15 @@ ArchiveOut& ArchiveOut::operator%(const std::array<TValue, n>& container) {
   return serializeOutContainer(*this, container);
 }
 
-template <typename TValue>
-ArchiveOut& ArchiveOut::operator%(const std::vector<TValue>& container) {
-  return serializeOutContainer(*this, container);
+template <typename TValue, typename TAllocator>
+ArchiveOut& ArchiveOut::operator%(
+    const std::vector<TValue, TAllocator>& container) {
+  // std::vector<bool> is not contiguous.
+  using IsBlock = std::integral_constant<
+      bool, std::is_arithmetic<TValue>::value &&
+                !std::is_same<TValue, bool>::value>;
+  writeVector(container, IsBlock());
+  return *this;
 }
 
 template <typename TValue, typename THash, typename TEqual>
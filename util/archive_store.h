@@ -0,0 +1,235 @@
+#ifndef UTIL_ARCHIVE_STORE_H_
+#define UTIL_ARCHIVE_STORE_H_
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "util/archive_in.h"
+#include "util/archive_out.h"
+
+namespace Alexandria {
+
+// Append only file of key value records.
+//
+// Keys and values are encoded with ArchiveOut and read back with ArchiveIn, so
+// both must be archivable.  Each encoding is prefixed by its size so that the
+// file can be indexed by key without reading the values.  The file is indexed
+// on first use and values are only read when asked for.  A record cut short by
+// a crash is dropped when the file is indexed.
+//
+// All member functions are thread safe.
+template <typename TKey, typename TValue, typename THash = std::hash<TKey>>
+class ArchiveStore {
+ public:
+  using Key = TKey;
+  using Value = TValue;
+
+  explicit ArchiveStore(std::string path) : path_(std::move(path)) {}
+
+  ArchiveStore(const ArchiveStore&) = delete;
+  ArchiveStore& operator=(const ArchiveStore&) = delete;
+
+  // Read the value stored for key.  Returns false if there is none.
+  bool find(const Key& key, Value* value);
+
+  // Append key and value unless key is stored already.
+  void insert(const Key& key, const Value& value);
+
+  bool contains(const Key& key);
+
+  // Number of records.
+  size_t size();
+
+  const std::string& path() const { return path_; }
+
+ private:
+  // Position of an encoded value in the file.
+  struct Location {
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  // First bytes of every store file.
+  static constexpr uint64_t kMagic = 0x3130545341524141ul;
+  static constexpr size_t kBufferSize = 4096;
+
+  // Open and index the file if not done yet.  The lock must be held.
+  void load();
+
+  template <typename T>
+  static std::string encode(const T& value);
+  template <typename T>
+  static void decode(const std::string& bytes, T* value);
+
+  // Read a size prefixed encoding at the current position.
+  bool readBlock(uint64_t file_size, std::string* bytes);
+
+  std::mutex mutex_;
+  std::string path_;
+  bool loaded_ = false;
+  std::fstream file_;
+  uint64_t end_ = 0;
+  std::unordered_map<Key, Location, THash> index_;
+};
+
+template <typename TKey, typename TValue, typename THash>
+constexpr uint64_t ArchiveStore<TKey, TValue, THash>::kMagic;
+
+template <typename TKey, typename TValue, typename THash>
+constexpr size_t ArchiveStore<TKey, TValue, THash>::kBufferSize;
+
+template <typename TKey, typename TValue, typename THash>
+bool ArchiveStore<TKey, TValue, THash>::find(const Key& key, Value* value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  load();
+
+  auto iter = index_.find(key);
+  if (iter == index_.end()) return false;
+
+  std::string bytes(iter->second.size, '\0');
+  file_.seekg(static_cast<std::streamoff>(iter->second.offset));
+  file_.read(&bytes[0], static_cast<std::streamsize>(bytes.size()));
+  if (!file_) throw std::runtime_error("unable to read " + path_);
+  decode(bytes, value);
+  return true;
+}
+
+template <typename TKey, typename TValue, typename THash>
+void ArchiveStore<TKey, TValue, THash>::insert(const Key& key,
+                                               const Value& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  load();
+  if (index_.find(key) != index_.end()) return;
+
+  const auto key_bytes = encode(key);
+  const auto value_bytes = encode(value);
+  const auto key_size = static_cast<uint64_t>(key_bytes.size());
+  const auto value_size = static_cast<uint64_t>(value_bytes.size());
+
+  file_.seekp(static_cast<std::streamoff>(end_));
+  file_.write(reinterpret_cast<const char*>(&key_size), sizeof(key_size));
+  file_.write(key_bytes.data(), static_cast<std::streamsize>(key_size));
+  file_.write(reinterpret_cast<const char*>(&value_size), sizeof(value_size));
+  file_.write(value_bytes.data(), static_cast<std::streamsize>(value_size));
+  file_.flush();
+  if (!file_) throw std::runtime_error("unable to write " + path_);
+
+  const auto offset = end_ + 2 * sizeof(uint64_t) + key_size;
+  index_.emplace(key, Location{offset, value_size});
+  end_ = offset + value_size;
+}
+
+template <typename TKey, typename TValue, typename THash>
+bool ArchiveStore<TKey, TValue, THash>::contains(const Key& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  load();
+  return index_.find(key) != index_.end();
+}
+
+template <typename TKey, typename TValue, typename THash>
+size_t ArchiveStore<TKey, TValue, THash>::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  load();
+  return index_.size();
+}
+
+template <typename TKey, typename TValue, typename THash>
+void ArchiveStore<TKey, TValue, THash>::load() {
+  if (loaded_) return;
+
+  // Create the file if it does not exist.
+  { std::ofstream(path_, std::ios::binary | std::ios::app); }
+  file_.open(path_, std::ios::binary | std::ios::in | std::ios::out);
+  if (!file_) throw std::runtime_error("unable to open " + path_);
+
+  file_.seekg(0, std::ios::end);
+  const auto file_size = static_cast<uint64_t>(file_.tellg());
+  file_.seekg(0);
+
+  if (file_size < sizeof(kMagic)) {
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&kMagic), sizeof(kMagic));
+    file_.flush();
+    if (!file_) throw std::runtime_error("unable to write " + path_);
+    end_ = sizeof(kMagic);
+  } else {
+    auto magic = uint64_t{0};
+    file_.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    if (magic != kMagic) {
+      throw std::invalid_argument(path_ + " is not an archive store");
+    }
+
+    end_ = sizeof(kMagic);
+    std::string key_bytes;
+    while (readBlock(file_size, &key_bytes)) {
+      auto value_size = uint64_t{0};
+      const auto offset = end_ + sizeof(uint64_t) + key_bytes.size();
+      if (offset + sizeof(value_size) > file_size) break;
+      file_.read(reinterpret_cast<char*>(&value_size), sizeof(value_size));
+      if (offset + sizeof(value_size) + value_size > file_size) break;
+
+      Key key;
+      decode(key_bytes, &key);
+      index_[key] = Location{offset + sizeof(value_size), value_size};
+      end_ = offset + sizeof(value_size) + value_size;
+      file_.seekg(static_cast<std::streamoff>(end_));
+    }
+
+    if (end_ < file_size) {
+      // Drop a partly written record.
+      file_.close();
+      if (::truncate(path_.c_str(), static_cast<off_t>(end_)) != 0) {
+        throw std::runtime_error("unable to truncate " + path_);
+      }
+      file_.open(path_, std::ios::binary | std::ios::in | std::ios::out);
+      if (!file_) throw std::runtime_error("unable to open " + path_);
+    }
+  }
+  file_.clear();
+  loaded_ = true;
+}
+
+template <typename TKey, typename TValue, typename THash>
+bool ArchiveStore<TKey, TValue, THash>::readBlock(uint64_t file_size,
+                                                  std::string* bytes) {
+  auto size = uint64_t{0};
+  if (end_ + sizeof(size) > file_size) return false;
+  file_.read(reinterpret_cast<char*>(&size), sizeof(size));
+  if (end_ + sizeof(size) + size > file_size) return false;
+
+  bytes->resize(size);
+  file_.read(&(*bytes)[0], static_cast<std::streamsize>(size));
+  return static_cast<bool>(file_);
+}
+
+template <typename TKey, typename TValue, typename THash>
+template <typename T>
+std::string ArchiveStore<TKey, TValue, THash>::encode(const T& value) {
+  std::ostringstream sout;
+  {
+    ArchiveOut ar(&sout, kBufferSize);
+    ar % value;
+  }
+  return sout.str();
+}
+
+template <typename TKey, typename TValue, typename THash>
+template <typename T>
+void ArchiveStore<TKey, TValue, THash>::decode(const std::string& bytes,
+                                               T* value) {
+  std::istringstream sin(bytes);
+  ArchiveIn ar(&sin, kBufferSize);
+  ar % (*value);
+}
+
+}  // namespace Alexandria
+
+#endif  // UTIL_ARCHIVE_STORE_H_
@@ -0,0 +1,158 @@
+#include "util/arena.h"
+
+#include <algorithm>
+#include <new>
+
+#include "util/profiler.h"
+
+namespace Alexandria {
+
+namespace {
+thread_local Arena* current_arena = nullptr;
+
+// Every ArenaAllocated object is preceded by a header naming the arena state
+// it came from, or nullptr for the heap, and the size allocated.
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+struct Header {
+  void* state;
+  size_t size;
+};
+static_assert(sizeof(Header) <= kHeaderSize, "header does not fit");
+
+size_t alignUp(size_t size) {
+  return (size + kHeaderSize - 1) / kHeaderSize * kHeaderSize;
+}
+
+// Free list entries are linked through their own memory.
+struct FreeNode {
+  FreeNode* next;
+};
+}  // namespace
+
+// The arena and each live object hold a reference on the state; the last one
+// to let go frees the blocks.
+struct Arena::State {
+  explicit State(size_t block_size)
+      : block_size(block_size),
+        position(block_size),
+        free_lists(block_size / 4 / kHeaderSize + 1, nullptr),
+        references(1ul),
+        n_allocations(0ul),
+        n_reused(0ul),
+        bytes_allocated(0ul) {}
+
+  void release() {
+    if (references.fetch_sub(1ul, std::memory_order_acq_rel) == 1ul) {
+      delete this;
+    }
+  }
+
+  size_t block_size;
+  size_t position;
+  std::vector<std::unique_ptr<char[]>> blocks;
+  std::vector<FreeNode*> free_lists;
+  std::atomic<size_t> references;
+  size_t n_allocations;
+  size_t n_reused;
+  size_t bytes_allocated;
+};
+
+constexpr size_t Arena::kDefaultBlockSize;
+
+Arena::Arena(size_t block_size)
+    : state_(new State(alignUp(std::max(block_size, kHeaderSize)))),
+      previous_(current_arena) {
+  current_arena = this;
+}
+
+Arena::~Arena() {
+  current_arena = previous_;
+  state_->release();
+}
+
+Arena* Arena::current() { return current_arena; }
+
+size_t Arena::nAllocations() const { return state_->n_allocations; }
+
+size_t Arena::nReused() const { return state_->n_reused; }
+
+size_t Arena::bytesAllocated() const { return state_->bytes_allocated; }
+
+size_t Arena::nBlocks() const { return state_->blocks.size(); }
+
+void* Arena::allocate(size_t size) {
+  auto& state = *state_;
+
+  char* result = nullptr;
+  const auto size_class = size / kHeaderSize;
+  if (size_class < state.free_lists.size() &&
+      state.free_lists[size_class] != nullptr) {
+    auto node = state.free_lists[size_class];
+    state.free_lists[size_class] = node->next;
+    result = reinterpret_cast<char*>(node);
+    ++state.n_reused;
+  } else if (size > state.block_size / 4) {
+    // Large objects get a block of their own so the current block is kept.
+    state.blocks.emplace_back(new char[size]);
+    result = state.blocks.back().get();
+  } else {
+    if (size > state.block_size - state.position) {
+      state.blocks.emplace_back(new char[state.block_size]);
+      state.position = 0ul;
+    }
+    result = state.blocks.back().get() + state.position;
+    state.position += size;
+  }
+
+  ++state.n_allocations;
+  state.bytes_allocated += size;
+  state.references.fetch_add(1ul, std::memory_order_relaxed);
+  return result;
+}
+
+void Arena::recycle(void* ptr, size_t size) {
+  auto& state = *state_;
+  const auto size_class = size / kHeaderSize;
+  if (size_class < state.free_lists.size()) {
+    auto node = static_cast<FreeNode*>(ptr);
+    node->next = state.free_lists[size_class];
+    state.free_lists[size_class] = node;
+  }
+  state.release();
+}
+
+void* ArenaAllocated::operator new(size_t size) {
+  auto arena = Arena::current();
+  const auto total = alignUp(kHeaderSize + size);
+
+  Header* header = nullptr;
+  if (arena != nullptr) {
+    header = static_cast<Header*>(arena->allocate(total));
+    header->state = arena->state_;
+  } else {
+    header = static_cast<Header*>(::operator new(total));
+    header->state = nullptr;
+  }
+  header->size = total;
+  Profiler::allocation(total);
+  return reinterpret_cast<char*>(header) + kHeaderSize;
+}
+
+void ArenaAllocated::operator delete(void* ptr) {
+  if (ptr == nullptr) return;
+
+  auto header =
+      reinterpret_cast<Header*>(static_cast<char*>(ptr) - kHeaderSize);
+  auto state = static_cast<Arena::State*>(header->state);
+  auto arena = Arena::current();
+  if (state == nullptr) {
+    ::operator delete(header);
+  } else if (arena != nullptr && arena->state_ == state) {
+    arena->recycle(header, header->size);
+  } else {
+    state->release();
+  }
+}
+
+}  // namespace Alexandria
@@ -0,0 +1,77 @@
+#ifndef UTIL_ARENA_H_
+#define UTIL_ARENA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Alexandria {
+
+// Bump allocator for many small, short lived objects.
+//
+// Constructing an Arena makes it the current arena of the thread until it goes
+// out of scope; arenas nest.  Classes deriving from ArenaAllocated are
+// allocated from the current arena when there is one and from the heap
+// otherwise.  Objects deleted while their arena is current are put on a free
+// list for their size and reused by later allocations.  The arena memory is
+// released en masse once the arena is out of scope and every object allocated
+// from it has been deleted, so objects may safely outlive the scope that
+// created them.
+//
+// E.g.
+//   {
+//     Arena arena;
+//     auto gradient = D(expression, x);  // nodes come from the arena
+//   }
+class Arena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64ul << 10;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize);
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // The current arena of this thread or nullptr.
+  static Arena* current();
+
+  // Number of objects allocated from the arena.
+  size_t nAllocations() const;
+
+  // Number of allocations served from a free list.
+  size_t nReused() const;
+
+  // Number of bytes handed out by the arena.
+  size_t bytesAllocated() const;
+
+  // Number of blocks obtained from the system allocator.
+  size_t nBlocks() const;
+
+ private:
+  friend class ArenaAllocated;
+  struct State;
+
+  // Allocate size bytes aligned for any fundamental type.  size must be a
+  // multiple of the alignment.
+  void* allocate(size_t size);
+
+  // Return memory from allocate to the free list for its size.
+  void recycle(void* ptr, size_t size);
+
+  State* state_;
+  Arena* previous_;
+};
+
+// Mixin to route operator new and delete of a class hierarchy through
+// Arena::current().
+class ArenaAllocated {
+ public:
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
+};
+
+}  // namespace Alexandria
+
+#endif  // UTIL_ARENA_H_
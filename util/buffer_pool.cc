@@ -0,0 +1,184 @@
+#include "util/buffer_pool.h"
+
+#include <sys/mman.h>
+
+#include <cstdlib>
+
+#include "util/profiler.h"
+
+namespace Alexandria {
+
+namespace {
+// Set once the thread cache has been destroyed at thread exit, so that
+// buffers released by later destructors go to the global cache.
+thread_local bool local_cache_destroyed = false;
+}  // namespace
+
+constexpr size_t BufferPool::kMinClass;
+constexpr size_t BufferPool::kNClasses;
+constexpr size_t BufferPool::kLocalCapacity;
+constexpr size_t BufferPool::kGlobalCapacity;
+constexpr size_t BufferPool::kAlignment;
+constexpr size_t BufferPool::kHugePageSize;
+
+// Buffers cached by a thread.  They are handed to the global cache when the
+// thread exits.
+struct BufferPool::LocalCache {
+  ~LocalCache() {
+    local_cache_destroyed = true;
+    auto& pool = bufferPool();
+    for (auto size_class = 0ul; size_class < kNClasses; ++size_class) {
+      for (auto ptr : buffers[size_class]) pool.releaseGlobal(size_class, ptr);
+    }
+  }
+
+  std::array<Buffers, kNClasses> buffers;
+};
+
+BufferPool::BufferPool()
+    : local_hits_(0ul),
+      global_hits_(0ul),
+      misses_(0ul),
+      frees_(0ul),
+      huge_pages_(0ul),
+      huge_page_threshold_(0ul) {}
+
+BufferPool::~BufferPool() {
+  for (auto& buffers : global_) {
+    for (auto ptr : buffers) systemFree(ptr);
+  }
+}
+
+size_t BufferPool::sizeClass(size_t size) {
+  auto size_class = 0ul;
+  while (size_class + 1 < kNClasses &&
+         (1ul << (size_class + kMinClass)) < size) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+auto BufferPool::localCache() -> LocalCache* {
+  if (local_cache_destroyed) return nullptr;
+  thread_local LocalCache cache;
+  return &cache;
+}
+
+void* BufferPool::allocate(size_t size) {
+  Profiler::allocation(size);
+  const auto size_class = sizeClass(size);
+  auto cache = localCache();
+  if (cache != nullptr && !cache->buffers[size_class].empty()) {
+    auto& local = cache->buffers[size_class];
+    auto ptr = local.back();
+    local.pop_back();
+    local_hits_.fetch_add(1ul, std::memory_order_relaxed);
+    return ptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& global = global_[size_class];
+    if (!global.empty()) {
+      auto ptr = global.back();
+      global.pop_back();
+      global_hits_.fetch_add(1ul, std::memory_order_relaxed);
+      return ptr;
+    }
+  }
+
+  misses_.fetch_add(1ul, std::memory_order_relaxed);
+  return systemAllocate(size_class);
+}
+
+void* BufferPool::systemAllocate(size_t size_class) {
+  const auto size = 1ul << (size_class + kMinClass);
+  const auto threshold = huge_page_threshold_.load();
+  const auto huge = threshold != 0ul && size >= threshold;
+
+  void* ptr = nullptr;
+  if (posix_memalign(&ptr, huge ? kHugePageSize : kAlignment, size) != 0) {
+    throw std::bad_alloc();
+  }
+
+#ifdef MADV_HUGEPAGE
+  // Only a hint; the kernel may still use normal pages.
+  if (huge && madvise(ptr, size, MADV_HUGEPAGE) == 0) {
+    huge_pages_.fetch_add(1ul, std::memory_order_relaxed);
+  }
+#endif
+  return ptr;
+}
+
+void BufferPool::systemFree(void* ptr) { std::free(ptr); }
+
+void BufferPool::deallocate(void* ptr, size_t size) {
+  if (ptr == nullptr) return;
+
+  const auto size_class = sizeClass(size);
+  auto cache = localCache();
+  if (cache != nullptr && cache->buffers[size_class].size() < kLocalCapacity) {
+    auto& local = cache->buffers[size_class];
+    if (local.capacity() == 0ul) local.reserve(kLocalCapacity);
+    local.emplace_back(ptr);
+    return;
+  }
+  releaseGlobal(size_class, ptr);
+}
+
+void BufferPool::releaseGlobal(size_t size_class, void* ptr) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& global = global_[size_class];
+    if (global.size() < kGlobalCapacity) {
+      if (global.capacity() == 0ul) global.reserve(kGlobalCapacity);
+      global.emplace_back(ptr);
+      return;
+    }
+  }
+  frees_.fetch_add(1ul, std::memory_order_relaxed);
+  systemFree(ptr);
+}
+
+auto BufferPool::statistics() const -> Statistics {
+  return {local_hits_.load(), global_hits_.load(), misses_.load(),
+          frees_.load(), huge_pages_.load()};
+}
+
+void BufferPool::resetStatistics() {
+  local_hits_ = 0ul;
+  global_hits_ = 0ul;
+  misses_ = 0ul;
+  frees_ = 0ul;
+  huge_pages_ = 0ul;
+}
+
+void BufferPool::setHugePageThreshold(size_t bytes) {
+  huge_page_threshold_ =
+      (bytes + kHugePageSize - 1ul) / kHugePageSize * kHugePageSize;
+}
+
+void BufferPool::clear() {
+  auto cache = localCache();
+  if (cache != nullptr) {
+    for (auto& buffers : cache->buffers) {
+      for (auto ptr : buffers) systemFree(ptr);
+      buffers.clear();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& buffers : global_) {
+    for (auto ptr : buffers) systemFree(ptr);
+    buffers.clear();
+  }
+}
+
+BufferPool& bufferPool() {
+  // Never destroyed, so that thread caches and static tensors destroyed at
+  // exit can still release their buffers.
+  static auto* pool = new BufferPool;
+  return *pool;
+}
+
+}  // namespace Alexandria
@@ -0,0 +1,137 @@
+#ifndef UTIL_BUFFER_POOL_H_
+#define UTIL_BUFFER_POOL_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace Alexandria {
+
+// Pool of raw buffers grouped in power of two size classes.
+//
+// Released buffers are cached in a small per thread cache first and in a
+// shared global cache after that, so buffers of the same size class are
+// recycled instead of going back to the system allocator.  Use through
+// bufferPool().
+//
+// Every buffer is aligned to kAlignment bytes.  Buffers of at least
+// hugePageThreshold() bytes are aligned to kHugePageSize instead and advised
+// to be backed by transparent huge pages, which cuts TLB misses when
+// streaming through large tensors.  Huge pages are off by default.
+class BufferPool {
+ public:
+  struct Statistics {
+    // Allocations served from the thread cache.
+    size_t local_hits;
+    // Allocations served from the global cache.
+    size_t global_hits;
+    // Allocations that called the system allocator.
+    size_t misses;
+    // Buffers returned to the system allocator.
+    size_t frees;
+    // Misses advised to be backed by huge pages.
+    size_t huge_pages;
+  };
+
+  // Size classes are powers of two from 2^kMinClass bytes.
+  static constexpr size_t kMinClass = 6;
+  static constexpr size_t kNClasses = 48;
+  // Cached buffers per size class.
+  static constexpr size_t kLocalCapacity = 4;
+  static constexpr size_t kGlobalCapacity = 16;
+  // Alignment of every buffer; enough for any SIMD load.
+  static constexpr size_t kAlignment = 64;
+  static constexpr size_t kHugePageSize = 2ul << 20;
+
+  BufferPool();
+  ~BufferPool();
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  // Allocate a buffer of at least size bytes.
+  void* allocate(size_t size);
+
+  // Return a buffer from allocate; size must be the size asked for.
+  void deallocate(void* ptr, size_t size);
+
+  Statistics statistics() const;
+  void resetStatistics();
+
+  // Release the cached buffers of the calling thread and the global cache.
+  void clear();
+
+  // Back new buffers of at least bytes bytes with huge pages; 0 disables.
+  // The threshold is rounded up to kHugePageSize.  Buffers already cached
+  // keep their backing until clear().
+  void setHugePageThreshold(size_t bytes);
+  size_t hugePageThreshold() const { return huge_page_threshold_; }
+
+ private:
+  struct LocalCache;
+  using Buffers = std::vector<void*>;
+
+  // Index of the size class for size bytes.
+  static size_t sizeClass(size_t size);
+
+  // The cache of the calling thread or nullptr once it has been destroyed.
+  static LocalCache* localCache();
+
+  // Move a buffer into the global cache or free it when full.
+  void releaseGlobal(size_t size_class, void* ptr);
+
+  // Get a buffer for size_class from the system allocator.
+  void* systemAllocate(size_t size_class);
+  static void systemFree(void* ptr);
+
+  mutable std::mutex mutex_;
+  std::array<Buffers, kNClasses> global_;
+
+  std::atomic<size_t> local_hits_;
+  std::atomic<size_t> global_hits_;
+  std::atomic<size_t> misses_;
+  std::atomic<size_t> frees_;
+  std::atomic<size_t> huge_pages_;
+  std::atomic<size_t> huge_page_threshold_;
+};
+
+// The process wide buffer pool.  It lives until the process exits, so
+// buffers may be released from any destructor.
+BufferPool& bufferPool();
+
+// Standard allocator drawing from bufferPool().  Storage is aligned to
+// BufferPool::kAlignment.
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  PoolAllocator() = default;
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(bufferPool().allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    bufferPool().deallocate(ptr, n * sizeof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+  return false;
+}
+
+}  // namespace Alexandria
+
+#endif  // UTIL_BUFFER_POOL_H_
@@ -1,15 +1,40 @@
 #ifndef UTIL_FUNCTION_CACHE_H_
 #define UTIL_FUNCTION_CACHE_H_
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "glog/logging.h"
+#include "util/archive_store.h"
 
 namespace Alexandria {
 
 // A function cache to recall results of functions with expansive calculations.
 // The input must have a hash.
+//
+// The cache is safe to use from several threads.  Entries are spread over
+// shards by hash, each with its own lock, and the function is evaluated outside
+// of any lock.  With a capacity the least recently used entry of a shard is
+// evicted once the shard is full.
+//
+// Concurrent misses on the same input are computed once: the first caller runs
+// the function and the others wait for its result, or its exception, on a
+// shared future.  Exceptions are not cached.
+//
+// attachStore adds a second tier in an ArchiveStore file: entries evicted from
+// memory are written to it, misses are looked up in it before calling the
+// function, and whatever is still in memory is written out on destruction.  A
+// cache attached to the same file in a later run starts from those results.
 template <typename TInput, typename TResult, typename THash = std::hash<TInput>>
 class FunctionCache {
  public:
@@ -17,42 +42,281 @@ class FunctionCache {
   using Result = TResult;
   using Hash = THash;
 
-  explicit FunctionCache(std::function<Result(Input)> function)
-      : function_(function) {}
+  struct Statistics {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    // Misses that waited for another thread's computation.
+    size_t waits;
+    // Misses served from the store.
+    size_t store_hits;
+  };
+
+  static constexpr size_t kDefaultShards = 16;
+
+  // A capacity of 0 is unbounded.  Otherwise capacity is split evenly between
+  // the shards, rounding up.
+  explicit FunctionCache(std::function<Result(Input)> function,
+                         size_t capacity = 0,
+                         size_t n_shards = kDefaultShards);
+
+  FunctionCache(const FunctionCache&) = delete;
+  FunctionCache& operator=(const FunctionCache&) = delete;
+
+  // Writes the cached entries to the store, if any.
+  ~FunctionCache();
 
   // Is the result of the input cached?
   bool isCached(const Input& input) const;
 
-  // Get that value from the cache or calculate and cache it.
-  const Result& operator()(const Input& input);
+  // Get that value from the cache or calculate and cache it.  Returned by value
+  // since the entry may be evicted by another thread.
+  Result operator()(const Input& input);
 
-  // Clear the cache.
-  void clearCache() { cache_.clear(); }
+  // Clear the cache.  Entries already in the store stay there.
+  void clearCache();
+
+  // Back the cache with the ArchiveStore at path, created if missing.  Input
+  // and Result must be archivable.  The file is only read when first needed.
+  // Not thread safe: attach the store before using the cache from several
+  // threads.
+  void attachStore(const std::string& path);
+
+  // Write the entries in memory that are not in the store yet.
+  void sync();
 
   // Return the size of the cache.
-  size_t cacheSize() const { return cache_.size(); }
+  size_t cacheSize() const;
+
+  size_t capacity() const { return shard_capacity_ * shards_.size(); }
+
+  Statistics statistics() const {
+    return {hits_.load(), misses_.load(), evictions_.load(), waits_.load(),
+            store_hits_.load()};
+  }
 
  private:
+  // Entries are kept most recently used first.
+  struct Shard {
+    using Entries = std::list<std::pair<Input, Result>>;
+
+    mutable std::mutex mutex;
+    Entries entries;
+    std::unordered_map<Input, typename Entries::iterator, Hash> index;
+    // Computations in flight.
+    std::unordered_map<Input, std::shared_future<Result>, Hash> pending;
+  };
+
+  // Cache result in shard, moving an entry it evicts to evicted.  The shard
+  // must be locked.
+  void insert(Shard* shard, const Input& input, const Result& result,
+              typename Shard::Entries* evicted);
+
+  // Write entries to the store, if any, outside of the shard locks.
+  void spill(const typename Shard::Entries& entries);
+
+  Shard& shard(const Input& input) const;
+
+  // Look input up in the store, or calculate it.
+  Result compute(const Input& input);
+
   std::function<Result(Input)> function_;
-  std::unordered_map<Input, Result, Hash> cache_;
+  Hash hash_;
+  size_t shard_capacity_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  // The store behind type erased callbacks, so that caches without one do not
+  // need archivable types.
+  std::shared_ptr<void> store_;
+  // The stored result or nullptr.
+  std::function<std::unique_ptr<Result>(const Input&)> load_;
+  std::function<void(const Input&, const Result&)> spill_;
+
+  std::atomic<size_t> hits_;
+  std::atomic<size_t> misses_;
+  std::atomic<size_t> evictions_;
+  std::atomic<size_t> waits_;
+  std::atomic<size_t> store_hits_;
 };
 
+template <typename TInput, typename TResult, typename THash>
+constexpr size_t FunctionCache<TInput, TResult, THash>::kDefaultShards;
+
+template <typename TInput, typename TResult, typename THash>
+FunctionCache<TInput, TResult, THash>::FunctionCache(
+    std::function<Result(Input)> function, size_t capacity, size_t n_shards)
+    : function_(function),
+      hits_(0),
+      misses_(0),
+      evictions_(0),
+      waits_(0),
+      store_hits_(0) {
+  if (n_shards == 0) n_shards = 1;
+  if (capacity > 0 && capacity < n_shards) n_shards = capacity;
+  shard_capacity_ = (capacity + n_shards - 1) / n_shards;
+  for (auto index = 0ul; index < n_shards; ++index) {
+    shards_.emplace_back(std::make_unique<Shard>());
+  }
+}
+
+template <typename TInput, typename TResult, typename THash>
+FunctionCache<TInput, TResult, THash>::~FunctionCache() {
+  if (!spill_) return;
+  try {
+    sync();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "unable to write function cache: " << e.what();
+  }
+}
+
+template <typename TInput, typename TResult, typename THash>
+void FunctionCache<TInput, TResult, THash>::attachStore(
+    const std::string& path) {
+  auto store = std::make_shared<ArchiveStore<Input, Result, Hash>>(path);
+  load_ = [store](const Input& input) {
+    auto result = std::make_unique<Result>();
+    if (!store->find(input, result.get())) result.reset();
+    return result;
+  };
+  spill_ = [store](const Input& input, const Result& result) {
+    store->insert(input, result);
+  };
+  store_ = store;
+}
+
+template <typename TInput, typename TResult, typename THash>
+void FunctionCache<TInput, TResult, THash>::sync() {
+  if (!spill_) return;
+  for (auto& shard : shards_) {
+    typename Shard::Entries entries;
+    {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      entries = shard->entries;
+    }
+    spill(entries);
+  }
+}
+
+template <typename TInput, typename TResult, typename THash>
+void FunctionCache<TInput, TResult, THash>::spill(
+    const typename Shard::Entries& entries) {
+  if (!spill_) return;
+  for (const auto& entry : entries) spill_(entry.first, entry.second);
+}
+
+template <typename TInput, typename TResult, typename THash>
+auto FunctionCache<TInput, TResult, THash>::compute(const Input& input)
+    -> Result {
+  if (load_) {
+    auto stored = load_(input);
+    if (stored) {
+      store_hits_.fetch_add(1, std::memory_order_relaxed);
+      return std::move(*stored);
+    }
+  }
+  return function_(input);
+}
+
+template <typename TInput, typename TResult, typename THash>
+auto FunctionCache<TInput, TResult, THash>::shard(const Input& input) const
+    -> Shard & {
+  // Mix the hash since the shard maps use its low bits too.
+  const auto hash = static_cast<uint64_t>(hash_(input)) * 0x9E3779B97F4A7C15ul;
+  return *shards_[(hash >> 32) % shards_.size()];
+}
+
 template <typename TInput, typename TResult, typename THash>
 bool FunctionCache<TInput, TResult, THash>::isCached(const Input& input) const {
-  return cache_.find(input) != cache_.end();
+  auto& shard = this->shard(input);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return shard.index.find(input) != shard.index.end();
 }
 
 template <typename TInput, typename TResult, typename THash>
 auto FunctionCache<TInput, TResult, THash>::operator()(const Input& input)
-    -> const Result & {
-  auto iter = cache_.find(input);
-  if (iter == cache_.end()) {
-    auto result = false;
-    std::tie(iter, result) = cache_.emplace(input, function_(input));
-    CHECK(result) << "Cannot insert into cache";
+    -> Result {
+  auto& shard = this->shard(input);
+  std::promise<Result> promise;
+  {
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto iter = shard.index.find(input);
+    if (iter != shard.index.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      return iter->second->second;
+    }
+
+    auto pending = shard.pending.find(input);
+    if (pending != shard.pending.end()) {
+      auto future = pending->second;
+      lock.unlock();
+      waits_.fetch_add(1, std::memory_order_relaxed);
+      return future.get();
+    }
+    shard.pending.emplace(input, promise.get_future().share());
   }
 
-  return iter->second;
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  auto released = false;
+  try {
+    auto result = compute(input);
+    typename Shard::Entries evicted;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      insert(&shard, input, result, &evicted);
+      shard.pending.erase(input);
+    }
+    promise.set_value(result);
+    released = true;
+
+    // Written out after the waiters are released and without the shard lock.
+    spill(evicted);
+    return result;
+  } catch (...) {
+    if (!released) {
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.pending.erase(input);
+      }
+      promise.set_exception(std::current_exception());
+    }
+    throw;
+  }
+}
+
+template <typename TInput, typename TResult, typename THash>
+void FunctionCache<TInput, TResult, THash>::insert(
+    Shard* shard, const Input& input, const Result& result,
+    typename Shard::Entries* evicted) {
+  // Only the caller that registered the pending computation gets here, so the
+  // input is not cached yet.
+  shard->entries.emplace_front(input, result);
+  shard->index.emplace(input, shard->entries.begin());
+  if (shard_capacity_ > 0 && shard->entries.size() > shard_capacity_) {
+    shard->index.erase(shard->entries.back().first);
+    evicted->splice(evicted->end(), shard->entries,
+                    std::prev(shard->entries.end()));
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+template <typename TInput, typename TResult, typename THash>
+void FunctionCache<TInput, TResult, THash>::clearCache() {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->index.clear();
+    shard->entries.clear();
+  }
+}
+
+template <typename TInput, typename TResult, typename THash>
+size_t FunctionCache<TInput, TResult, THash>::cacheSize() const {
+  auto size = 0ul;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    size += shard->entries.size();
+  }
+  return size;
 }
 
 }  // namespace Alexandria
@@ -0,0 +1,86 @@
+#include "util/instrumentation.h"
+
+#include <utility>
+
+namespace Alexandria {
+
+namespace {
+thread_local ScopedTimer* current_timer = nullptr;
+}  // namespace
+
+void Instrumentation::record(const std::string& operation, uint64_t elements,
+                             uint64_t bytes, uint64_t nanoseconds) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& counters = report_[operation];
+  ++counters.calls;
+  counters.elements += elements;
+  counters.bytes += bytes;
+  counters.nanoseconds += nanoseconds;
+}
+
+auto Instrumentation::report() const -> Report {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return report_;
+}
+
+void Instrumentation::reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  report_.clear();
+}
+
+void Instrumentation::dumpText(std::ostream* out) const {
+  for (const auto& entry : report()) {
+    const auto& counters = entry.second;
+    *out << entry.first << ": calls=" << counters.calls
+         << " elements=" << counters.elements << " bytes=" << counters.bytes
+         << " time_ms=" << counters.nanoseconds / 1E6 << "\n";
+  }
+}
+
+void Instrumentation::dumpJson(std::ostream* out) const {
+  *out << "{";
+  auto first = true;
+  for (const auto& entry : report()) {
+    const auto& counters = entry.second;
+    *out << (first ? "\n" : ",\n") << "  \"" << entry.first << "\": {"
+         << "\"calls\": " << counters.calls
+         << ", \"elements\": " << counters.elements
+         << ", \"bytes\": " << counters.bytes
+         << ", \"nanoseconds\": " << counters.nanoseconds << "}";
+    first = false;
+  }
+  *out << (first ? "}\n" : "\n}\n");
+}
+
+Instrumentation& instrumentation() {
+  static Instrumentation instrumentation;
+  return instrumentation;
+}
+
+ScopedTimer::ScopedTimer(std::string operation, uint64_t elements)
+    : operation_(std::move(operation)),
+      elements_(elements),
+      bytes_(0),
+      parent_(current_timer),
+      start_(std::chrono::steady_clock::now()) {
+  current_timer = this;
+}
+
+ScopedTimer::~ScopedTimer() {
+  const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start_)
+                               .count();
+  current_timer = parent_;
+  instrumentation().record(operation_, elements_, bytes_,
+                           static_cast<uint64_t>(nanoseconds));
+}
+
+ScopedTimer* ScopedTimer::current() { return current_timer; }
+
+void recordAllocation(const std::string& operation, uint64_t elements,
+                      uint64_t bytes) {
+  instrumentation().record(operation, elements, bytes, 0);
+  if (current_timer != nullptr) current_timer->addBytes(bytes);
+}
+
+}  // namespace Alexandria
@@ -0,0 +1,170 @@
+#ifndef UTIL_INSTRUMENTATION_H_
+#define UTIL_INSTRUMENTATION_H_
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+namespace Alexandria {
+
+// Per operation counters and timers for hot paths.
+//
+// Each operation, e.g. "multiply dense*sparse", accumulates the number of
+// calls, the elements processed, the bytes allocated and the wall time spent.
+// Code is instrumented through the INSTRUMENT_* macros below, which compile to
+// nothing unless ALEXANDRIA_INSTRUMENT is defined (cmake -DINSTRUMENT=ON), so
+// uninstrumented builds pay nothing.  Use through instrumentation().
+//
+// Recording takes a lock, so instrumented builds are meant for profiling
+// runs rather than production.
+class Instrumentation {
+ public:
+  struct Counters {
+    uint64_t calls;
+    uint64_t elements;
+    uint64_t bytes;
+    uint64_t nanoseconds;
+  };
+
+  // Counters by operation name.
+  using Report = std::map<std::string, Counters>;
+
+  Instrumentation() = default;
+  Instrumentation(const Instrumentation&) = delete;
+  Instrumentation& operator=(const Instrumentation&) = delete;
+
+  // Whether the INSTRUMENT_* macros are compiled in.
+  static constexpr bool enabled() {
+#ifdef ALEXANDRIA_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // Add one call of operation.
+  void record(const std::string& operation, uint64_t elements, uint64_t bytes,
+              uint64_t nanoseconds);
+
+  Report report() const;
+  void reset();
+
+  // One line per operation, sorted by name.
+  void dumpText(std::ostream* out) const;
+
+  // An object of operation names to their counters.
+  void dumpJson(std::ostream* out) const;
+
+ private:
+  mutable std::mutex mutex_;
+  Report report_;
+};
+
+// The process wide instrumentation.
+Instrumentation& instrumentation();
+
+// Times the enclosing scope and records it as one call of operation.  Bytes
+// allocated while the timer is the innermost one of its thread are added to
+// its count.
+class ScopedTimer {
+ public:
+  ScopedTimer(std::string operation, uint64_t elements);
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  void addBytes(uint64_t bytes) { bytes_ += bytes; }
+
+  // The innermost timer of the calling thread or nullptr.
+  static ScopedTimer* current();
+
+ private:
+  std::string operation_;
+  uint64_t elements_;
+  uint64_t bytes_;
+  ScopedTimer* parent_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Records one call of operation when the hash map grows its buckets before the
+// end of the enclosing scope.
+template <typename TMap>
+class RehashCounter {
+ public:
+  RehashCounter(const char* operation, const TMap& map)
+      : operation_(operation), map_(map), n_buckets_(map.bucket_count()) {}
+
+  ~RehashCounter() {
+    if (map_.bucket_count() != n_buckets_) {
+      instrumentation().record(operation_, map_.size(),
+                               map_.bucket_count() * sizeof(void*), 0);
+    }
+  }
+
+  RehashCounter(const RehashCounter&) = delete;
+  RehashCounter& operator=(const RehashCounter&) = delete;
+
+ private:
+  const char* operation_;
+  const TMap& map_;
+  size_t n_buckets_;
+};
+
+// Record an allocation of bytes for elements as one call of operation, and
+// add the bytes to the innermost timer.
+void recordAllocation(const std::string& operation, uint64_t elements,
+                      uint64_t bytes);
+
+}  // namespace Alexandria
+
+#ifdef ALEXANDRIA_INSTRUMENT
+#define ALEXANDRIA_INSTRUMENT_NAME2(name, line) name##line
+#define ALEXANDRIA_INSTRUMENT_NAME(name, line) \
+  ALEXANDRIA_INSTRUMENT_NAME2(name, line)
+
+// Time the rest of the scope as one call of operation on elements.
+#define INSTRUMENT_SCOPE(operation, elements)                               \
+  ::Alexandria::ScopedTimer ALEXANDRIA_INSTRUMENT_NAME(instrument_scope_, \
+                                                       __LINE__)(         \
+      (operation), static_cast<uint64_t>(elements))
+
+// Count one call of operation without timing it.
+#define INSTRUMENT_COUNT(operation, elements, bytes)          \
+  ::Alexandria::instrumentation().record(                    \
+      (operation), static_cast<uint64_t>(elements),          \
+      static_cast<uint64_t>(bytes), 0)
+
+// Count an allocation of bytes, also charged to the enclosing scope.
+#define INSTRUMENT_ALLOCATION(operation, elements, bytes) \
+  ::Alexandria::recordAllocation((operation),             \
+                                 static_cast<uint64_t>(elements), \
+                                 static_cast<uint64_t>(bytes))
+
+// Count a call of operation if map rehashes before the end of the scope, with
+// its size as elements and its bucket array as bytes.
+#define INSTRUMENT_REHASH(operation, map)                                  \
+  ::Alexandria::RehashCounter<typename std::decay<decltype(map)>::type>   \
+  ALEXANDRIA_INSTRUMENT_NAME(instrument_rehash_, __LINE__)((operation), \
+                                                           (map))
+#else
+// The arguments are not evaluated.
+#define INSTRUMENT_SCOPE(operation, elements) \
+  do {                                        \
+  } while (false)
+#define INSTRUMENT_COUNT(operation, elements, bytes) \
+  do {                                               \
+  } while (false)
+#define INSTRUMENT_ALLOCATION(operation, elements, bytes) \
+  do {                                                    \
+  } while (false)
+#define INSTRUMENT_REHASH(operation, map) \
+  do {                                    \
+  } while (false)
+#endif
+
+#endif  // UTIL_INSTRUMENTATION_H_
@@ -0,0 +1,161 @@
+#ifndef UTIL_PHILOX_H_
+#define UTIL_PHILOX_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace Alexandria {
+
+// Philox4x32-10 counter based random number generator (Salmon et al., "Parallel
+// random numbers: as easy as 1, 2, 3").
+//
+// The output is a pure function of (seed, stream, offset): word offset of
+// stream of seed is the same no matter which thread computes it or what was
+// generated before, so a range can be split between threads and still produce
+// bitwise identical values.  Satisfies UniformRandomBitGenerator and can be
+// used with the standard distributions.
+class Philox {
+ public:
+  using result_type = uint32_t;
+  using Counter = std::array<uint32_t, 4>;
+  using Key = std::array<uint32_t, 2>;
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  // Generator positioned at 32 bit word offset of stream.
+  explicit Philox(uint64_t seed, uint64_t stream = 0, uint64_t offset = 0)
+      : key_{{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}},
+        stream_(stream) {
+    seek(offset);
+  }
+
+  result_type operator()() {
+    if (index_ == 4) {
+      ++block_;
+      output_ = block(counter(), key_);
+      index_ = 0;
+    }
+    return output_[index_++];
+  }
+
+  // Write the next words to [first, last), a whole block at a time.
+  void generate(uint32_t* first, uint32_t* last) {
+    while (index_ < 4 && first != last) *first++ = output_[index_++];
+    while (last - first >= static_cast<std::ptrdiff_t>(4 * kLanes)) {
+      blocks(block_ + 1, first);
+      block_ += kLanes;
+      first += 4 * kLanes;
+    }
+    while (last - first >= 4) {
+      ++block_;
+      output_ = block(counter(), key_);
+      first = std::copy(output_.cbegin(), output_.cend(), first);
+    }
+    while (first != last) *first++ = (*this)();
+  }
+
+  // Skip n words in O(1).
+  void discard(uint64_t n) { seek(offset() + n); }
+
+  // Position to word offset of the stream.
+  void seek(uint64_t offset) {
+    block_ = offset / 4;
+    index_ = static_cast<size_t>(offset % 4);
+    output_ = block(counter(), key_);
+  }
+
+  // Word offset of the next output.
+  uint64_t offset() const { return block_ * 4 + index_; }
+
+  uint64_t stream() const { return stream_; }
+
+  // The ten round Philox bijection of counter under key.
+  static Counter block(Counter counter, Key key) {
+    for (auto round = 0; round < 10; ++round) {
+      if (round > 0) {
+        key[0] += kWeyl0;
+        key[1] += kWeyl1;
+      }
+      const auto product0 = uint64_t{kMultiplier0} * counter[0];
+      const auto product1 = uint64_t{kMultiplier1} * counter[2];
+      counter = {{static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                  static_cast<uint32_t>(product1),
+                  static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                  static_cast<uint32_t>(product0)}};
+    }
+    return counter;
+  }
+
+  // Blocks computed side by side by generate.
+  static constexpr size_t kLanes = 64;
+
+  friend bool operator==(const Philox& x, const Philox& y) {
+    return x.key_ == y.key_ && x.stream_ == y.stream_ &&
+           x.offset() == y.offset();
+  }
+
+ private:
+  static constexpr uint32_t kMultiplier0 = 0xD2511F53;
+  static constexpr uint32_t kMultiplier1 = 0xCD9E8D57;
+  static constexpr uint32_t kWeyl0 = 0x9E3779B9;
+  static constexpr uint32_t kWeyl1 = 0xBB67AE85;
+
+  // Write kLanes blocks from first_block on to out.  The rounds run lane by
+  // lane over separate arrays so that the compiler can vectorize them.
+  void blocks(uint64_t first_block, uint32_t* out) const {
+    uint32_t x0[kLanes], x1[kLanes], x2[kLanes], x3[kLanes];
+    for (auto lane = 0ul; lane < kLanes; ++lane) {
+      const auto block = first_block + lane;
+      x0[lane] = static_cast<uint32_t>(block);
+      x1[lane] = static_cast<uint32_t>(block >> 32);
+      x2[lane] = static_cast<uint32_t>(stream_);
+      x3[lane] = static_cast<uint32_t>(stream_ >> 32);
+    }
+
+    auto key0 = key_[0];
+    auto key1 = key_[1];
+    for (auto round = 0; round < 10; ++round) {
+      for (auto lane = 0ul; lane < kLanes; ++lane) {
+        const auto product0 = uint64_t{kMultiplier0} * x0[lane];
+        const auto product1 = uint64_t{kMultiplier1} * x2[lane];
+        const auto y1 = x1[lane];
+        const auto y3 = x3[lane];
+        x0[lane] = static_cast<uint32_t>(product1 >> 32) ^ y1 ^ key0;
+        x1[lane] = static_cast<uint32_t>(product1);
+        x2[lane] = static_cast<uint32_t>(product0 >> 32) ^ y3 ^ key1;
+        x3[lane] = static_cast<uint32_t>(product0);
+      }
+      key0 += kWeyl0;
+      key1 += kWeyl1;
+    }
+
+    for (auto lane = 0ul; lane < kLanes; ++lane) {
+      out[4 * lane] = x0[lane];
+      out[4 * lane + 1] = x1[lane];
+      out[4 * lane + 2] = x2[lane];
+      out[4 * lane + 3] = x3[lane];
+    }
+  }
+
+  Counter counter() const {
+    return {{static_cast<uint32_t>(block_), static_cast<uint32_t>(block_ >> 32),
+             static_cast<uint32_t>(stream_),
+             static_cast<uint32_t>(stream_ >> 32)}};
+  }
+
+  Key key_;
+  uint64_t stream_;
+  uint64_t block_;
+  size_t index_;
+  Counter output_;
+};
+
+}  // namespace Alexandria
+
+#endif  // UTIL_PHILOX_H_
@@ -0,0 +1,233 @@
+#include "util/profiler.h"
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
+
+namespace Alexandria {
+
+namespace {
+thread_local Profiler* current_profiler = nullptr;
+
+// Write s as a JSON string.
+void writeString(std::ostream* out, const std::string& s) {
+  *out << '"';
+  for (const auto c : s) {
+    if (c == '"' || c == '\\') {
+      *out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      *out << ' ';
+    } else {
+      *out << c;
+    }
+  }
+  *out << '"';
+}
+
+// Strip the namespaces, enclosing classes and template arguments of a
+// demangled name.
+std::string unqualified(const std::string& name) {
+  auto end = name.size();
+  auto depth = 0;
+  // Drop trailing template arguments.
+  while (end > 0 && name[end - 1] == '>') {
+    auto position = end;
+    do {
+      --position;
+      if (name[position] == '>') ++depth;
+      if (name[position] == '<') --depth;
+    } while (position > 0 && depth > 0);
+    end = position;
+  }
+
+  // Last component outside of template arguments.
+  auto begin = 0ul;
+  depth = 0;
+  for (auto position = 0ul; position < end; ++position) {
+    if (name[position] == '<') ++depth;
+    if (name[position] == '>') --depth;
+    if (depth == 0 && position + 1 < end && name[position] == ':' &&
+        name[position + 1] == ':') {
+      begin = position + 2;
+    }
+  }
+  return name.substr(begin, end - begin);
+}
+}  // namespace
+
+constexpr size_t Profiler::kNoParent;
+
+Profiler::Profiler()
+    : open_(kNoParent), origin_(0), previous_(current_profiler) {
+  origin_ = now();
+  current_profiler = this;
+}
+
+Profiler::~Profiler() { current_profiler = previous_; }
+
+Profiler* Profiler::current() { return current_profiler; }
+
+void Profiler::allocation(size_t bytes) {
+  auto profiler = current_profiler;
+  if (profiler == nullptr || profiler->open_ == kNoParent) return;
+  auto& event = profiler->events_[profiler->open_];
+  ++event.allocations;
+  event.bytes += bytes;
+}
+
+std::string Profiler::typeName(const std::type_info& type) {
+  static std::mutex mutex;
+  static std::unordered_map<std::type_index, std::string> names;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto iter = names.find(type);
+  if (iter != names.end()) return iter->second;
+
+  auto status = 0;
+  std::unique_ptr<char, void (*)(void*)> demangled(
+      abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free);
+  const auto name =
+      unqualified(status == 0 ? std::string(demangled.get()) : type.name());
+  names.emplace(type, name);
+  return name;
+}
+
+uint64_t Profiler::now() const {
+  return static_cast<uint64_t>(
+             std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+                 .count()) -
+         origin_;
+}
+
+size_t Profiler::open(std::string category, std::string name) {
+  events_.push_back({std::move(name), std::move(category), now(), 0, open_, 0,
+                     0, std::string(), 0});
+  open_ = events_.size() - 1;
+  return open_;
+}
+
+void Profiler::close(size_t index) {
+  auto& event = events_[index];
+  event.duration = now() - event.start;
+  open_ = event.parent;
+  if (open_ != kNoParent) {
+    events_[open_].allocations += event.allocations;
+    events_[open_].bytes += event.bytes;
+  }
+}
+
+auto Profiler::summary() const -> Summaries {
+  Summaries result;
+  for (const auto& event : events_) {
+    auto& summary = result[{event.category, event.name}];
+    ++summary.calls;
+    summary.nanoseconds += event.duration;
+    summary.self_nanoseconds += event.duration;
+    summary.allocations += event.allocations;
+    summary.bytes += event.bytes;
+    if (event.parent != kNoParent) {
+      const auto& parent = events_[event.parent];
+      result[{parent.category, parent.name}].self_nanoseconds -=
+          event.duration;
+    }
+  }
+  return result;
+}
+
+void Profiler::dumpSummary(std::ostream* out) const {
+  const auto summaries = summary();
+  std::vector<Summaries::const_iterator> sorted;
+  for (auto iter = summaries.cbegin(); iter != summaries.cend(); ++iter) {
+    sorted.emplace_back(iter);
+  }
+  using Iterator = Summaries::const_iterator;
+  std::stable_sort(sorted.begin(), sorted.end(), [](Iterator x, Iterator y) {
+    return x->second.nanoseconds > y->second.nanoseconds;
+  });
+
+  for (const auto& iter : sorted) {
+    const auto& summary = iter->second;
+    *out << iter->first.first << " " << iter->first.second
+         << ": calls=" << summary.calls
+         << " time_ms=" << summary.nanoseconds / 1E6
+         << " self_ms=" << summary.self_nanoseconds / 1E6
+         << " allocations=" << summary.allocations
+         << " bytes=" << summary.bytes << "\n";
+  }
+}
+
+void Profiler::dumpChromeTrace(std::ostream* out) const {
+  *out << "{\"traceEvents\": [";
+  auto first = true;
+  for (const auto& event : events_) {
+    *out << (first ? "\n" : ",\n") << "  {\"name\": ";
+    writeString(out, event.name);
+    *out << ", \"cat\": ";
+    writeString(out, event.category);
+    *out << ", \"ph\": \"X\", \"ts\": " << event.start / 1E3
+         << ", \"dur\": " << event.duration / 1E3
+         << ", \"pid\": 1, \"tid\": 1, \"args\": {\"allocations\": "
+         << event.allocations << ", \"bytes\": " << event.bytes;
+    if (!event.storage.empty()) {
+      *out << ", \"storage\": ";
+      writeString(out, event.storage);
+      *out << ", \"nnz\": " << event.nnz;
+    }
+    *out << "}}";
+    first = false;
+  }
+  *out << "\n], \"displayTimeUnit\": \"ns\"}\n";
+}
+
+void Profiler::dumpFolded(std::ostream* out) const {
+  // Self time per stack, the stacks in lexicographic order.
+  std::map<std::string, uint64_t> stacks;
+  std::vector<std::string> names(events_.size());
+  std::vector<uint64_t> self(events_.size());
+  for (auto index = 0ul; index < events_.size(); ++index) {
+    const auto& event = events_[index];
+    const auto frame = event.category + " " + event.name;
+    names[index] = event.parent == kNoParent
+                       ? frame
+                       : names[event.parent] + ";" + frame;
+    self[index] += event.duration;
+    if (event.parent != kNoParent) self[event.parent] -= event.duration;
+  }
+  for (auto index = 0ul; index < events_.size(); ++index) {
+    stacks[names[index]] += self[index];
+  }
+  for (const auto& stack : stacks) {
+    *out << stack.first << " " << stack.second / 1000 << "\n";
+  }
+}
+
+ProfileScope::ProfileScope(const char* category, const std::type_info& type)
+    : profiler_(Profiler::current()), index_(0) {
+  if (profiler_ != nullptr) {
+    index_ = profiler_->open(category, Profiler::typeName(type));
+  }
+}
+
+ProfileScope::ProfileScope(const char* category, std::string name)
+    : profiler_(Profiler::current()), index_(0) {
+  if (profiler_ != nullptr) index_ = profiler_->open(category, std::move(name));
+}
+
+ProfileScope::~ProfileScope() {
+  if (profiler_ != nullptr) profiler_->close(index_);
+}
+
+void ProfileScope::setOutput(std::string storage, size_t nnz) {
+  if (profiler_ == nullptr) return;
+  profiler_->events_[index_].storage = std::move(storage);
+  profiler_->events_[index_].nnz = nnz;
+}
+
+}  // namespace Alexandria
@@ -0,0 +1,135 @@
+#ifndef UTIL_PROFILER_H_
+#define UTIL_PROFILER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace Alexandria {
+
+// Records a tree of timed spans, e.g. the calls into an AD expression graph.
+//
+// Constructing a Profiler makes it the current profiler of the thread until it
+// goes out of scope; profilers nest.  ProfileScope spans opened while a
+// profiler is current are recorded with their nesting, the allocations made
+// inside them and, optionally, the storage kind and number of stored elements
+// of their output.  Without a current profiler a ProfileScope costs a thread
+// local load.
+//
+// The spans can be exported as Chrome trace event JSON, for chrome://tracing
+// or Perfetto, or as folded stacks for flamegraph.pl.
+//
+// E.g.
+//   {
+//     Profiler profiler;
+//     value(D(loss, w).evaluateAt({x = x_value}));
+//     profiler.dumpChromeTrace(&out);
+//   }
+class Profiler {
+ public:
+  static constexpr size_t kNoParent = static_cast<size_t>(-1);
+
+  struct Event {
+    std::string name;
+    // Kind of span, e.g. evaluateAt.
+    std::string category;
+    // Nanoseconds since the profiler was constructed.
+    uint64_t start;
+    uint64_t duration;
+    // Index of the enclosing event or kNoParent.
+    size_t parent;
+    // Allocations made inside the span, including its children.
+    uint64_t allocations;
+    uint64_t bytes;
+    // Storage kind and number of stored elements of the output, if set.
+    std::string storage;
+    size_t nnz;
+  };
+
+  // Totals per (category, name).
+  struct Summary {
+    uint64_t calls;
+    uint64_t nanoseconds;
+    // Time not spent in child spans.
+    uint64_t self_nanoseconds;
+    uint64_t allocations;
+    uint64_t bytes;
+  };
+  using Summaries = std::map<std::pair<std::string, std::string>, Summary>;
+
+  Profiler();
+  ~Profiler();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  // The current profiler of this thread or nullptr.
+  static Profiler* current();
+
+  // Charge an allocation of bytes to the innermost open span of the current
+  // profiler, if any.
+  static void allocation(size_t bytes);
+
+  // The unqualified name of a class, e.g. Plus for AD<T>::Plus.
+  static std::string typeName(const std::type_info& type);
+
+  // Events in the order they were opened.
+  const std::vector<Event>& events() const { return events_; }
+
+  Summaries summary() const;
+
+  // One line per (category, name), by decreasing time.
+  void dumpSummary(std::ostream* out) const;
+
+  // Chrome trace event JSON with a complete ("X") event per span.
+  void dumpChromeTrace(std::ostream* out) const;
+
+  // One "category;name;name... self_microseconds" line per distinct stack, as
+  // read by flamegraph.pl.
+  void dumpFolded(std::ostream* out) const;
+
+ private:
+  friend class ProfileScope;
+
+  // Open a span and return its index.
+  size_t open(std::string category, std::string name);
+  void close(size_t index);
+
+  uint64_t now() const;
+
+  std::vector<Event> events_;
+  // Innermost open event or kNoParent.
+  size_t open_;
+  uint64_t origin_;
+  Profiler* previous_;
+};
+
+// A span recorded by the current profiler, if any, from construction to
+// destruction.
+class ProfileScope {
+ public:
+  ProfileScope(const char* category, const std::type_info& type);
+  ProfileScope(const char* category, std::string name);
+  ~ProfileScope();
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+  // Whether a profiler records this span.
+  bool active() const { return profiler_ != nullptr; }
+
+  void setOutput(std::string storage, size_t nnz);
+
+ private:
+  Profiler* profiler_;
+  size_t index_;
+};
+
+}  // namespace Alexandria
+
+#endif  // UTIL_PROFILER_H_
@@ -1,22 +1,38 @@
 #include "util/rng.h"
 
+#include <functional>
 #include <string>
 
 namespace Alexandria {
 
-void Rng::serializeInImpl(ArchiveIn& ar, size_t /*version*/) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  auto state = std::string();
-  ar % state;
-  std::istringstream sin(state);
-  sin >> generator_;
+constexpr uint64_t Rng::kDefaultSeed;
+constexpr size_t Rng::kChunkSize;
+constexpr size_t Rng::kParallelThreshold;
+constexpr uint64_t Rng::kChunkStride;
+
+void Rng::seed(uint64_t seed) {
+  seed_ = seed;
+  next_stream_ = 0ul;
+}
+
+void Rng::serializeInImpl(ArchiveIn& ar, size_t version) {
+  if (version == 0) {
+    // Mersenne twister state; derive a seed from it.
+    auto state = std::string();
+    ar % state;
+    seed(std::hash<std::string>()(state));
+    return;
+  }
+
+  auto seed_value = uint64_t{0};
+  auto next_stream = uint64_t{0};
+  ar % seed_value % next_stream;
+  seed_ = seed_value;
+  next_stream_ = next_stream;
 }
 
 void Rng::serializeOutImpl(ArchiveOut& ar) const {
-  std::lock_guard<std::mutex> lock(mutex_);
-  std::ostringstream sout;
-  sout << generator_;
-  ar % sout.str();
+  ar % seed_ % next_stream_.load();
 }
 
 }  // namespace Alexandria
@@ -2,48 +2,221 @@
 #define UTIL_RNG_H_
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
 #include <random>
-#include <mutex>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "util/philox.h"
+#include "util/samplers.h"
 #include "util/singleton.h"
 #include "util/serializable.h"
 
 namespace Alexandria {
 
 // Random number generator singleton.
+//
+// Draws from the counter based Philox generator.  Every call to generate takes
+// a fresh stream from an atomic counter, so calls from several threads do not
+// contend for a lock, and a sequence of calls is reproducible from the seed.
+// Within a call the values are generated in chunks of kChunkSize, each from
+// its own fixed position of the stream, so large calls are split between
+// threads with the same result as a serial fill.  fill and bernoulli write
+// straight into existing storage.  Uniform and normal real distributions are
+// sampled in bulk, see util/samplers.h.
 class Rng : public Singleton<Rng>, public Serializable {
  public:
+  static constexpr uint64_t kDefaultSeed = 5489;
+  // Values generated from one position of a stream.
+  static constexpr size_t kChunkSize = 1ul << 14;
+  // Calls of at least this many values are split between threads.
+  static constexpr size_t kParallelThreshold = 1ul << 18;
+
+  Rng() : seed_(kDefaultSeed), next_stream_(0) {}
   virtual ~Rng() {}
 
   template <typename TDistribution>
   using result_type = std::vector<typename TDistribution::result_type>;
 
   template <typename TDistribution>
-  result_type<TDistribution> generate(TDistribution distribution, size_t n = 1);
+  result_type<TDistribution> generate(const TDistribution& distribution,
+                                      size_t n = 1);
+
+  // Fill [first, last) in place.  TIterator must be random access.
+  template <typename TDistribution, typename TIterator>
+  void fill(const TDistribution& distribution, TIterator first,
+            TIterator last);
+
+  // Write 1 to out for each probability in [first, last) that succeeds and 0
+  // otherwise.  out may be first.
+  template <typename TInputIterator, typename TOutputIterator>
+  void bernoulli(TInputIterator first, TInputIterator last,
+                 TOutputIterator out);
+
+  // Restart from seed.  Not safe to call concurrently with generate.
+  void seed(uint64_t seed);
+  uint64_t seed() const { return seed_; }
 
-  /* TODO(alvin): add function to set seed */
+  // Reserve a stream nobody else will draw from.
+  uint64_t nextStream() { return next_stream_.fetch_add(1ul); }
+
+  // Generator at offset of stream.
+  Philox engine(uint64_t stream, uint64_t offset = 0) const {
+    return Philox(seed_, stream, offset);
+  }
 
  private:
+  // Distance between the positions of consecutive chunks in a stream.
+  static constexpr uint64_t kChunkStride = 1ul << 32;
+
+  // Fill [first, first + n) from stream.
+  template <typename TDistribution, typename TIterator>
+  void fill(const TDistribution& distribution, TIterator first, size_t n,
+            uint64_t stream) const;
+
+  // Fill [first, last) from engine.  Uniform and normal real distributions
+  // go through the bulk Samplers; anything else is drawn one at a time.
+  template <typename TDistribution, typename TIterator>
+  static void fillChunk(const TDistribution& distribution, Philox& engine,
+                        TIterator first, TIterator last);
+  template <typename TValue, typename TIterator>
+  static void fillChunk(
+      const std::uniform_real_distribution<TValue>& distribution,
+      Philox& engine, TIterator first, TIterator last);
+  template <typename TValue, typename TIterator>
+  static void fillChunk(const std::normal_distribution<TValue>& distribution,
+                        Philox& engine, TIterator first, TIterator last);
+
+  // Fill [first, last) a block at a time with sampler(block_first,
+  // block_last).
+  template <typename TValue, typename TIterator, typename TSampler>
+  static void fillBlocks(TIterator first, TIterator last, TSampler sampler);
+
+  // Call fn(engine, begin, end) for each chunk of [0, n), on several threads
+  // if parallel and n is large enough.  Chunks of a std::vector<bool> share
+  // words, so those must not be filled in parallel.
+  template <typename TFn>
+  void forEachChunk(size_t n, uint64_t stream, bool parallel, TFn fn) const;
+
   void serializeInImpl(ArchiveIn& ar, size_t version) final;
   void serializeOutImpl(ArchiveOut& ar) const final;
-  size_t serializeOutVersionImpl() const final { return 0; }
+  size_t serializeOutVersionImpl() const final { return 1; }
 
-  mutable std::mutex mutex_;
-  std::mt19937 generator_;
+  uint64_t seed_;
+  std::atomic<uint64_t> next_stream_;
 };
 
 template <typename TDistribution>
-Rng::result_type<TDistribution> Rng::generate(TDistribution distribution,
-                                              size_t n) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  result_type<TDistribution> result;
+Rng::result_type<TDistribution> Rng::generate(
+    const TDistribution& distribution, size_t n) {
+  result_type<TDistribution> result(n);
+  fill(distribution, result.begin(), n, nextStream());
+  return result;
+}
 
-  result.reserve(n);
-  generate_n(back_inserter(result), n,
-             [this, &distribution]() { return distribution(generator_); });
+template <typename TDistribution, typename TIterator>
+void Rng::fill(const TDistribution& distribution, TIterator first,
+               TIterator last) {
+  fill(distribution, first, static_cast<size_t>(std::distance(first, last)),
+       nextStream());
+}
 
-  return result;
+template <typename TInputIterator, typename TOutputIterator>
+void Rng::bernoulli(TInputIterator first, TInputIterator last,
+                    TOutputIterator out) {
+  using value_type = typename std::iterator_traits<TOutputIterator>::value_type;
+  forEachChunk(static_cast<size_t>(std::distance(first, last)), nextStream(),
+               !std::is_same<value_type, bool>::value,
+               [first, out](Philox& engine, size_t begin, size_t end) {
+                 std::uniform_real_distribution<double> uniform;
+                 const auto offset = static_cast<std::ptrdiff_t>(begin);
+                 std::transform(
+                     first + offset,
+                     first + static_cast<std::ptrdiff_t>(end), out + offset,
+                     [&](double probability) {
+                       return static_cast<value_type>(
+                           uniform(engine) < probability ? 1 : 0);
+                     });
+               });
+}
+
+template <typename TDistribution, typename TIterator>
+void Rng::fill(const TDistribution& distribution, TIterator first, size_t n,
+               uint64_t stream) const {
+  using value_type = typename std::iterator_traits<TIterator>::value_type;
+  forEachChunk(n, stream, !std::is_same<value_type, bool>::value,
+               [&distribution, first](Philox& engine, size_t begin,
+                                      size_t end) {
+                 fillChunk(distribution, engine,
+                           first + static_cast<std::ptrdiff_t>(begin),
+                           first + static_cast<std::ptrdiff_t>(end));
+               });
+}
+
+template <typename TDistribution, typename TIterator>
+void Rng::fillChunk(const TDistribution& distribution, Philox& engine,
+                    TIterator first, TIterator last) {
+  auto chunk_distribution = distribution;
+  std::generate(first, last, [&]() { return chunk_distribution(engine); });
+}
+
+template <typename TValue, typename TIterator>
+void Rng::fillChunk(const std::uniform_real_distribution<TValue>& distribution,
+                    Philox& engine, TIterator first, TIterator last) {
+  fillBlocks<TValue>(first, last, [&](TValue* block_first, TValue* block_last) {
+    Samplers::uniform(engine, distribution.a(), distribution.b(), block_first,
+                      block_last);
+  });
+}
+
+template <typename TValue, typename TIterator>
+void Rng::fillChunk(const std::normal_distribution<TValue>& distribution,
+                    Philox& engine, TIterator first, TIterator last) {
+  fillBlocks<TValue>(first, last, [&](TValue* block_first, TValue* block_last) {
+    Samplers::normal(engine, distribution.mean(), distribution.stddev(),
+                     block_first, block_last);
+  });
+}
+
+template <typename TValue, typename TIterator, typename TSampler>
+void Rng::fillBlocks(TIterator first, TIterator last, TSampler sampler) {
+  std::array<TValue, Samplers::kBlockSize> block;
+  while (first != last) {
+    const auto n = std::min(Samplers::kBlockSize,
+                            static_cast<size_t>(std::distance(first, last)));
+    sampler(block.data(), block.data() + n);
+    first = std::copy_n(block.cbegin(), n, first);
+  }
+}
+
+template <typename TFn>
+void Rng::forEachChunk(size_t n, uint64_t stream, bool parallel,
+                       TFn fn) const {
+  const auto n_chunks = (n + kChunkSize - 1) / kChunkSize;
+  auto run_chunks = [&](size_t begin_chunk, size_t step) {
+    for (auto chunk = begin_chunk; chunk < n_chunks; chunk += step) {
+      auto engine = this->engine(stream, chunk * kChunkStride);
+      const auto begin = chunk * kChunkSize;
+      fn(engine, begin, std::min(begin + kChunkSize, n));
+    }
+  };
+
+  const auto n_threads = std::min<size_t>(
+      n_chunks, std::max(1u, std::thread::hardware_concurrency()));
+  if (!parallel || n < kParallelThreshold || n_threads < 2) {
+    run_chunks(0, 1);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  for (auto index = 1ul; index < n_threads; ++index) {
+    threads.emplace_back(run_chunks, index, n_threads);
+  }
+  run_chunks(0, n_threads);
+  for (auto& thread : threads) thread.join();
 }
 
 inline Rng& rng() { return Rng::instance(); }
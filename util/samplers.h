@@ -0,0 +1,103 @@
+#ifndef UTIL_SAMPLERS_H_
+#define UTIL_SAMPLERS_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "util/philox.h"
+
+namespace Alexandria {
+
+// Bulk samplers writing blocks of variates from a Philox generator.
+//
+// Raw words are generated a whole block at a time and converted in separate
+// branch free loops that the compiler can vectorize.  Normal variates use the
+// Box-Muller transform, which unlike the Ziggurat method has no rejection
+// step and so vectorizes.
+namespace Samplers {
+
+// Variates converted per block.
+constexpr size_t kBlockSize = 256;
+
+// Words used per uniform variate: 24 bit floats take one, 53 bit doubles two.
+template <typename T>
+constexpr size_t wordsPerValue() {
+  return sizeof(T) <= sizeof(uint32_t) ? 1 : 2;
+}
+
+// Convert words to uniform [0, 1) values.  Goes through signed 32 bit
+// integers, which unlike 64 bit ones convert to floating point in SIMD.
+inline void toUnit(const uint32_t* words, size_t n, float* out) {
+  for (auto index = 0ul; index < n; ++index) {
+    out[index] = static_cast<float>(static_cast<int32_t>(words[index] >> 8)) *
+                 (1.0f / 16777216.0f);
+  }
+}
+
+template <typename T>
+void toUnit(const uint32_t* words, size_t n, T* out) {
+  for (auto index = 0ul; index < n; ++index) {
+    const auto high = static_cast<int32_t>(words[2 * index] >> 5);
+    const auto low = static_cast<int32_t>(words[2 * index + 1] >> 6);
+    out[index] = static_cast<T>(
+        (static_cast<double>(high) * 67108864.0 + static_cast<double>(low)) *
+        (1.0 / 9007199254740992.0));
+  }
+}
+
+// Fill [first, last) with uniform [a, b) values.
+template <typename T>
+void uniform(Philox& engine, T a, T b, T* first, T* last) {
+  static_assert(std::is_floating_point<T>::value, "floating point only");
+
+  std::array<uint32_t, kBlockSize * wordsPerValue<T>()> words;
+  const auto scale = b - a;
+  while (first != last) {
+    const auto n = std::min(kBlockSize, static_cast<size_t>(last - first));
+    engine.generate(words.data(), words.data() + n * wordsPerValue<T>());
+    toUnit(words.data(), n, first);
+    for (auto index = 0ul; index < n; ++index) {
+      first[index] = a + scale * first[index];
+    }
+    first += n;
+  }
+}
+
+// Fill [first, last) with normal values.
+template <typename T>
+void normal(Philox& engine, T mean, T stddev, T* first, T* last) {
+  static_assert(std::is_floating_point<T>::value, "floating point only");
+
+  std::array<uint32_t, kBlockSize * wordsPerValue<T>()> words;
+  std::array<T, kBlockSize> unit;
+  const auto two_pi = static_cast<T>(2.0 * M_PI);
+  while (first != last) {
+    // Whole pairs, so a block may draw one value more than it writes.
+    const auto n = std::min(kBlockSize, static_cast<size_t>(last - first));
+    const auto n_pairs = (n + 1) / 2;
+    engine.generate(words.data(),
+                    words.data() + 2 * n_pairs * wordsPerValue<T>());
+    toUnit(words.data(), 2 * n_pairs, unit.data());
+
+    // First halves hold the radii, second halves the angles.
+    for (auto index = 0ul; index < n_pairs; ++index) {
+      const auto radius = std::sqrt(-2 * std::log(1 - unit[index]));
+      const auto angle = two_pi * unit[n_pairs + index];
+      unit[index] = radius * std::cos(angle);
+      unit[n_pairs + index] = radius * std::sin(angle);
+    }
+    for (auto index = 0ul; index < n; ++index) {
+      first[index] = mean + stddev * unit[index];
+    }
+    first += n;
+  }
+}
+
+}  // namespace Samplers
+
+}  // namespace Alexandria
+
+#endif  // UTIL_SAMPLERS_H_
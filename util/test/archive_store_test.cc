@@ -0,0 +1,95 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "util/archive_store.h"
+
+TEST(ArchiveStore, Reopen) {
+  using Alexandria::ArchiveStore;
+
+  const auto path = ::testing::TempDir() + "archive_store_reopen";
+  std::remove(path.c_str());
+
+  {
+    ArchiveStore<std::string, std::vector<double>> store(path);
+    EXPECT_EQ(store.size(), 0);
+    store.insert("a", {1.0, 2.0});
+    store.insert("b", {});
+    // Keys are only stored once.
+    store.insert("a", {3.0});
+    EXPECT_EQ(store.size(), 2);
+  }
+
+  ArchiveStore<std::string, std::vector<double>> store(path);
+  std::vector<double> value;
+  EXPECT_TRUE(store.find("a", &value));
+  EXPECT_EQ(value, std::vector<double>({1.0, 2.0}));
+  EXPECT_TRUE(store.find("b", &value));
+  EXPECT_TRUE(value.empty());
+  EXPECT_FALSE(store.find("c", &value));
+
+  store.insert("c", {4.0});
+  EXPECT_TRUE(store.find("c", &value));
+  EXPECT_EQ(value, std::vector<double>({4.0}));
+
+  std::remove(path.c_str());
+}
+
+TEST(ArchiveStore, Truncated) {
+  using Alexandria::ArchiveStore;
+
+  const auto path = ::testing::TempDir() + "archive_store_truncated";
+  std::remove(path.c_str());
+
+  {
+    ArchiveStore<int, std::string> store(path);
+    store.insert(1, "one");
+    store.insert(2, "two");
+  }
+
+  // Cut the last record short as a crash while writing would.
+  std::ifstream fin(path, std::ios::binary | std::ios::ate);
+  const auto size = static_cast<off_t>(fin.tellg());
+  fin.close();
+  ASSERT_EQ(::truncate(path.c_str(), size - 2), 0);
+
+  {
+    ArchiveStore<int, std::string> store(path);
+    EXPECT_EQ(store.size(), 1);
+    EXPECT_FALSE(store.contains(2));
+    store.insert(3, "three");
+  }
+
+  ArchiveStore<int, std::string> store(path);
+  std::string value;
+  EXPECT_TRUE(store.find(1, &value));
+  EXPECT_EQ(value, "one");
+  EXPECT_TRUE(store.find(3, &value));
+  EXPECT_EQ(value, "three");
+
+  std::remove(path.c_str());
+}
+
+TEST(ArchiveStore, NotAStore) {
+  using Alexandria::ArchiveStore;
+
+  const auto path = ::testing::TempDir() + "archive_store_invalid";
+  std::ofstream(path) << "not an archive store";
+
+  ArchiveStore<int, int> store(path);
+  EXPECT_THROW(store.size(), std::invalid_argument);
+
+  std::remove(path.c_str());
+}
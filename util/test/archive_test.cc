@@ -7,6 +7,10 @@
 #include "gtest/gtest.h"
 #pragma clang diagnostic pop
 
+#include <unistd.h>
+
+#include <cstdio>
+#include <numeric>
 #include <sstream>
 
 #include "util/archive_in.h"
@@ -65,6 +69,7 @@ TEST(Archive, Primitive) {
   string string_out = "abcdefg";
   ar_out % string_out;
 
+  ar_out.flush();
   std::istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
 
@@ -136,6 +141,7 @@ TEST(Archive, Array) {
   std::array<int, 4> array_out({{4, 5, 7, 5}});
   ar_out % array_out;
 
+  ar_out.flush();
   istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
   std::array<int, 4> array_in;
@@ -156,6 +162,7 @@ TEST(Archive, Vector) {
   std::vector<int> vec_out({4, 5, 7, 5});
   ar_out % vec_out;
 
+  ar_out.flush();
   istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
   std::vector<int> vec_in;
@@ -183,6 +190,7 @@ TEST(Archive, UnorderedSet) {
   std::unordered_set<int> set_out({4, 5, 7, 5});
   ar_out % set_out;
 
+  ar_out.flush();
   istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
   std::unordered_set<int> set_in;
@@ -203,6 +211,7 @@ TEST(Archive, UnorderedMap) {
   std::unordered_map<int, char> map_out({{4, 'a'}, {2, 'b'}, {3, 'c'}});
   ar_out % map_out;
 
+  ar_out.flush();
   istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
   std::unordered_map<int, char> map_in;
@@ -211,3 +220,59 @@ TEST(Archive, UnorderedMap) {
 
   EXPECT_EQ(map_in, map_out);
 }
+
+TEST(Archive, SmallBuffer) {
+  using std::ostringstream;
+  using std::istringstream;
+  using Alexandria::ArchiveOut;
+  using Alexandria::ArchiveIn;
+
+  // Buffers smaller than the values force refills and write-throughs.
+  ostringstream sout;
+  ArchiveOut ar_out(&sout, 3);
+  std::vector<double> vec_out({1.5, 2.5, 3.5, 4.5});
+  std::string string_out = "abcdefghijk";
+  std::map<int, std::string> map_out({{1, "a"}, {2, "bc"}});
+  ar_out % vec_out % string_out % map_out % 42;
+  ar_out.flush();
+
+  istringstream sin(sout.str());
+  ArchiveIn ar_in(&sin, 5);
+  std::vector<double> vec_in;
+  std::string string_in;
+  std::map<int, std::string> map_in;
+  int int_in = 0;
+  ar_in % vec_in % string_in % map_in % int_in;
+
+  EXPECT_EQ(vec_in, vec_out);
+  EXPECT_EQ(string_in, string_out);
+  EXPECT_EQ(map_in, map_out);
+  EXPECT_EQ(int_in, 42);
+  EXPECT_THROW(ar_in % int_in, std::runtime_error);
+}
+
+TEST(Archive, FileDescriptor) {
+  using Alexandria::ArchiveOut;
+  using Alexandria::ArchiveIn;
+
+  auto file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  const auto fd = fileno(file);
+
+  std::vector<float> vec_out(10000);
+  std::iota(vec_out.begin(), vec_out.end(), 0.0f);
+  {
+    ArchiveOut ar_out(fd, 1024);
+    ar_out % vec_out % std::string("end");
+  }
+
+  lseek(fd, 0, SEEK_SET);
+  ArchiveIn ar_in(fd, 1024);
+  std::vector<float> vec_in;
+  std::string string_in;
+  ar_in % vec_in % string_in;
+
+  EXPECT_EQ(vec_in, vec_out);
+  EXPECT_EQ(string_in, "end");
+  std::fclose(file);
+}
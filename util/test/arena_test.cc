@@ -0,0 +1,92 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include <memory>
+#include <vector>
+
+#include "util/arena.h"
+
+namespace {
+class Node : public Alexandria::ArenaAllocated {
+ public:
+  explicit Node(int value) : value_(value), values_(4, value) {}
+  virtual ~Node() {}
+
+  int value() const { return value_; }
+
+ private:
+  int value_;
+  std::vector<int> values_;
+};
+}  // namespace
+
+TEST(Arena, Allocate) {
+  using Alexandria::Arena;
+
+  EXPECT_EQ(Arena::current(), nullptr);
+  auto heap_node = std::make_unique<Node>(1);
+
+  {
+    Arena arena(1024);
+    EXPECT_EQ(Arena::current(), &arena);
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (auto index = 0; index < 100; ++index) {
+      nodes.emplace_back(std::make_unique<Node>(index));
+    }
+
+    EXPECT_EQ(arena.nAllocations(), 100ul);
+    EXPECT_GT(arena.nBlocks(), 1ul);
+    EXPECT_LT(arena.nBlocks(), 100ul);
+    for (auto index = 0; index < 100; ++index) {
+      EXPECT_EQ(nodes[static_cast<size_t>(index)]->value(), index);
+    }
+
+    {
+      Arena inner;
+      EXPECT_EQ(Arena::current(), &inner);
+      auto node = std::make_unique<Node>(3);
+      EXPECT_EQ(inner.nAllocations(), 1ul);
+    }
+    EXPECT_EQ(Arena::current(), &arena);
+    EXPECT_EQ(arena.nAllocations(), 100ul);
+  }
+
+  EXPECT_EQ(Arena::current(), nullptr);
+  EXPECT_EQ(heap_node->value(), 1);
+}
+
+TEST(Arena, OutliveScope) {
+  using Alexandria::Arena;
+
+  std::unique_ptr<Node> node;
+  {
+    Arena arena;
+    node = std::make_unique<Node>(7);
+  }
+
+  // The arena memory is kept alive until the last node is deleted.
+  EXPECT_EQ(node->value(), 7);
+  node.reset();
+}
+
+TEST(Arena, Reuse) {
+  using Alexandria::Arena;
+
+  Arena arena;
+  for (auto index = 0; index < 100; ++index) {
+    auto node = std::make_unique<Node>(index);
+    EXPECT_EQ(node->value(), index);
+  }
+
+  // Every node after the first reuses the memory of the one before.
+  EXPECT_EQ(arena.nAllocations(), 100ul);
+  EXPECT_EQ(arena.nReused(), 99ul);
+  EXPECT_EQ(arena.nBlocks(), 1ul);
+}
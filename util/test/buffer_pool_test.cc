@@ -0,0 +1,142 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "tensor/tensor.h"
+#include "util/buffer_pool.h"
+
+namespace {
+// Constructed before the pool and destroyed after it.
+Alexandria::Tensor<double> kept;
+}  // namespace
+
+TEST(BufferPool, Reuse) {
+  using Alexandria::bufferPool;
+
+  bufferPool().clear();
+  bufferPool().resetStatistics();
+
+  auto ptr1 = bufferPool().allocate(1000);
+  bufferPool().deallocate(ptr1, 1000);
+
+  // Same size class.
+  auto ptr2 = bufferPool().allocate(1020);
+  EXPECT_EQ(ptr1, ptr2);
+  bufferPool().deallocate(ptr2, 1020);
+
+  auto stats = bufferPool().statistics();
+  EXPECT_EQ(stats.misses, 1ul);
+  EXPECT_EQ(stats.local_hits, 1ul);
+
+  // Different size class.
+  auto ptr3 = bufferPool().allocate(3000);
+  bufferPool().deallocate(ptr3, 3000);
+  EXPECT_EQ(bufferPool().statistics().misses, 2ul);
+
+  bufferPool().clear();
+}
+
+TEST(BufferPool, GlobalFallback) {
+  using Alexandria::bufferPool;
+
+  bufferPool().clear();
+  bufferPool().resetStatistics();
+
+  // Buffers released by an exiting thread are handed to the global cache.
+  std::thread thread([]() {
+    auto ptr = bufferPool().allocate(512);
+    bufferPool().deallocate(ptr, 512);
+  });
+  thread.join();
+
+  auto ptr = bufferPool().allocate(512);
+  bufferPool().deallocate(ptr, 512);
+
+  auto stats = bufferPool().statistics();
+  EXPECT_EQ(stats.misses, 1ul);
+  EXPECT_EQ(stats.global_hits, 1ul);
+
+  bufferPool().clear();
+}
+
+TEST(BufferPool, Allocator) {
+  using Alexandria::bufferPool;
+  using Alexandria::PoolAllocator;
+
+  bufferPool().clear();
+  bufferPool().resetStatistics();
+
+  for (auto iteration = 0; iteration < 10; ++iteration) {
+    std::vector<double, PoolAllocator<double>> values(100, 1.0);
+    std::vector<double, PoolAllocator<double>> copy(values);
+    EXPECT_EQ(values, copy);
+  }
+
+  // Steady state after the first iteration.
+  EXPECT_EQ(bufferPool().statistics().misses, 2ul);
+
+  bufferPool().clear();
+}
+
+TEST(BufferPool, Alignment) {
+  using Alexandria::BufferPool;
+  using Alexandria::bufferPool;
+  using Alexandria::PoolAllocator;
+
+  bufferPool().clear();
+
+  for (auto size : {1ul, 8ul, 100ul, 4096ul, 100000ul}) {
+    auto ptr = bufferPool().allocate(size);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % BufferPool::kAlignment, 0ul);
+    bufferPool().deallocate(ptr, size);
+  }
+
+  std::vector<float, PoolAllocator<float>> values(3);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(values.data()) % BufferPool::kAlignment,
+            0ul);
+
+  bufferPool().clear();
+}
+
+TEST(BufferPool, StaticTensor) {
+  using Alexandria::Shape;
+  using Alexandria::Tensor;
+
+  // The storage is released to the pool at exit, after the thread cache.
+  kept = Tensor<double>::dense(Shape({100}));
+  EXPECT_EQ(kept.size(), 100ul);
+}
+
+TEST(BufferPool, HugePages) {
+  using Alexandria::BufferPool;
+  using Alexandria::bufferPool;
+
+  bufferPool().clear();
+  bufferPool().setHugePageThreshold(1ul);
+  EXPECT_EQ(bufferPool().hugePageThreshold(), BufferPool::kHugePageSize);
+
+  const auto size = 2 * BufferPool::kHugePageSize;
+  auto large = bufferPool().allocate(size);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % BufferPool::kHugePageSize,
+            0ul);
+
+  // Small buffers are unaffected.
+  auto small = bufferPool().allocate(1000);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % BufferPool::kAlignment, 0ul);
+
+  bufferPool().deallocate(large, size);
+  bufferPool().deallocate(small, 1000);
+
+  bufferPool().setHugePageThreshold(0ul);
+  EXPECT_EQ(bufferPool().hugePageThreshold(), 0ul);
+  bufferPool().clear();
+}
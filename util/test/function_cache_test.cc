@@ -7,6 +7,10 @@
 #include "gtest/gtest.h"
 #pragma clang diagnostic pop
 
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 #include "util/function_cache.h"
@@ -33,3 +37,149 @@ TEST(FunctionCache, Cache) {
   fn.clearCache();
   EXPECT_EQ(fn.cacheSize(), 0);
 }
+
+TEST(FunctionCache, NoDefaultConstructor) {
+  using Alexandria::FunctionCache;
+
+  // Results are only built by the function.
+  struct Result {
+    explicit Result(int x) : value(x) {}
+    int value;
+  };
+  FunctionCache<int, Result> fn([](int value) { return Result(value * 2); },
+                                1);
+  EXPECT_EQ(fn(1).value, 2);
+  EXPECT_EQ(fn(2).value, 4);
+  EXPECT_EQ(fn(1).value, 2);
+  EXPECT_EQ(fn.statistics().evictions, 2ul);
+}
+
+TEST(FunctionCache, Eviction) {
+  using Alexandria::FunctionCache;
+
+  auto n_calls = 0;
+  FunctionCache<int, int> fn(
+      [&n_calls](int value) {
+        ++n_calls;
+        return 2 * value;
+      },
+      2, 1);
+
+  EXPECT_EQ(fn.capacity(), 2);
+  EXPECT_EQ(fn(1), 2);
+  EXPECT_EQ(fn(2), 4);
+  // 1 becomes the most recently used so 2 is evicted next.
+  EXPECT_EQ(fn(1), 2);
+  EXPECT_EQ(fn(3), 6);
+
+  EXPECT_TRUE(fn.isCached(1));
+  EXPECT_FALSE(fn.isCached(2));
+  EXPECT_TRUE(fn.isCached(3));
+  EXPECT_EQ(fn.cacheSize(), 2);
+  EXPECT_EQ(n_calls, 3);
+
+  auto statistics = fn.statistics();
+  EXPECT_EQ(statistics.hits, 1);
+  EXPECT_EQ(statistics.misses, 3);
+  EXPECT_EQ(statistics.evictions, 1);
+}
+
+TEST(FunctionCache, Concurrent) {
+  using Alexandria::FunctionCache;
+
+  FunctionCache<int, int> fn([](int value) { return value * value; }, 64);
+
+  std::vector<std::thread> threads;
+  std::atomic<int> n_wrong(0);
+  for (auto index = 0; index < 8; ++index) {
+    threads.emplace_back([&fn, &n_wrong, index]() {
+      for (auto value = 0; value < 10000; ++value) {
+        const auto input = (value * (index + 1)) % 200;
+        if (fn(input) != input * input) ++n_wrong;
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  EXPECT_EQ(n_wrong, 0);
+  EXPECT_LE(fn.cacheSize(), fn.capacity());
+  auto statistics = fn.statistics();
+  EXPECT_EQ(statistics.hits + statistics.misses + statistics.waits, 80000);
+}
+
+TEST(FunctionCache, SingleFlight) {
+  using Alexandria::FunctionCache;
+
+  const auto n_threads = 8ul;
+  std::atomic<size_t> n_calls(0);
+  FunctionCache<int, int> fn([&fn, &n_calls](int value) {
+    // Hold each threaded computation until every other thread waits for it.
+    const auto call = ++n_calls;
+    while (call <= 2 && fn.statistics().waits < (n_threads - 1) * call) {
+      std::this_thread::yield();
+    }
+    if (value < 0) throw std::invalid_argument("negative");
+    return value + 1;
+  });
+
+  std::vector<std::thread> threads;
+  std::atomic<int> n_wrong(0);
+  std::atomic<size_t> n_thrown(0);
+  for (auto index = 0ul; index < n_threads; ++index) {
+    threads.emplace_back([&]() {
+      if (fn(1) != 2) ++n_wrong;
+      try {
+        fn(-1);
+      } catch (const std::invalid_argument&) {
+        ++n_thrown;
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  // Each input was computed once and every waiter saw the exception.
+  EXPECT_EQ(n_calls, 2ul);
+  EXPECT_EQ(n_wrong, 0);
+  EXPECT_EQ(n_thrown, n_threads);
+  EXPECT_EQ(fn.statistics().misses, 2ul);
+  EXPECT_EQ(fn.statistics().waits, 2 * (n_threads - 1));
+
+  // Exceptions are not cached.
+  EXPECT_FALSE(fn.isCached(-1));
+  EXPECT_THROW(fn(-1), std::invalid_argument);
+  EXPECT_EQ(n_calls, 3ul);
+}
+
+TEST(FunctionCache, Store) {
+  using Alexandria::FunctionCache;
+
+  const auto path = ::testing::TempDir() + "function_cache_store";
+  std::remove(path.c_str());
+
+  auto n_calls = 0;
+  auto function = [&n_calls](int value) {
+    ++n_calls;
+    return std::vector<int>(3, value);
+  };
+
+  {
+    FunctionCache<int, std::vector<int>> fn(function, 2, 1);
+    fn.attachStore(path);
+    for (auto value = 0; value < 4; ++value) fn(value);
+    // Evicted entries are looked up in the store.
+    EXPECT_EQ(fn(0), std::vector<int>(3, 0));
+    EXPECT_EQ(fn.statistics().store_hits, 1);
+    EXPECT_EQ(n_calls, 4);
+  }
+
+  // A new cache starts from the results of the previous one.
+  FunctionCache<int, std::vector<int>> fn(function);
+  fn.attachStore(path);
+  for (auto value = 0; value < 4; ++value) {
+    EXPECT_EQ(fn(value), std::vector<int>(3, value));
+  }
+  EXPECT_EQ(fn.statistics().store_hits, 4);
+  EXPECT_EQ(n_calls, 4);
+
+  std::remove(path.c_str());
+}
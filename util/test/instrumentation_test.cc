@@ -0,0 +1,121 @@
+// Compiled with the instrumentation on, whatever the build setting.
+#ifndef ALEXANDRIA_INSTRUMENT
+#define ALEXANDRIA_INSTRUMENT
+#endif
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include <sstream>
+#include <string>
+
+#include "tensor/tensor.h"
+#include "util/instrumentation.h"
+
+TEST(Instrumentation, Record) {
+  using Alexandria::instrumentation;
+
+  instrumentation().reset();
+  instrumentation().record("a", 10, 80, 5);
+  instrumentation().record("a", 20, 0, 7);
+  instrumentation().record("b", 1, 2, 3);
+
+  const auto report = instrumentation().report();
+  ASSERT_EQ(report.size(), 2);
+  EXPECT_EQ(report.at("a").calls, 2);
+  EXPECT_EQ(report.at("a").elements, 30);
+  EXPECT_EQ(report.at("a").bytes, 80);
+  EXPECT_EQ(report.at("a").nanoseconds, 12);
+
+  std::ostringstream text;
+  instrumentation().dumpText(&text);
+  EXPECT_EQ(text.str(),
+            "a: calls=2 elements=30 bytes=80 time_ms=1.2e-05\n"
+            "b: calls=1 elements=1 bytes=2 time_ms=3e-06\n");
+
+  std::ostringstream json;
+  instrumentation().dumpJson(&json);
+  EXPECT_EQ(json.str(),
+            "{\n"
+            "  \"a\": {\"calls\": 2, \"elements\": 30, \"bytes\": 80, "
+            "\"nanoseconds\": 12},\n"
+            "  \"b\": {\"calls\": 1, \"elements\": 1, \"bytes\": 2, "
+            "\"nanoseconds\": 3}\n"
+            "}\n");
+
+  instrumentation().reset();
+  std::ostringstream empty;
+  instrumentation().dumpJson(&empty);
+  EXPECT_EQ(empty.str(), "{}\n");
+}
+
+TEST(Instrumentation, ScopedTimer) {
+  using Alexandria::ScopedTimer;
+  using Alexandria::instrumentation;
+  using Alexandria::recordAllocation;
+
+  instrumentation().reset();
+  EXPECT_EQ(ScopedTimer::current(), nullptr);
+  {
+    ScopedTimer outer("outer", 3);
+    recordAllocation("allocate", 1, 8);
+    {
+      ScopedTimer inner("inner", 4);
+      EXPECT_EQ(ScopedTimer::current(), &inner);
+      recordAllocation("allocate", 2, 16);
+    }
+    EXPECT_EQ(ScopedTimer::current(), &outer);
+  }
+  EXPECT_EQ(ScopedTimer::current(), nullptr);
+
+  const auto report = instrumentation().report();
+  EXPECT_EQ(report.at("outer").calls, 1);
+  EXPECT_EQ(report.at("outer").elements, 3);
+  EXPECT_EQ(report.at("outer").bytes, 8);
+  EXPECT_GE(report.at("outer").nanoseconds, report.at("inner").nanoseconds);
+  EXPECT_EQ(report.at("inner").bytes, 16);
+  EXPECT_EQ(report.at("allocate").calls, 2);
+  EXPECT_EQ(report.at("allocate").bytes, 24);
+}
+
+TEST(Instrumentation, Tensor) {
+  using Alexandria::Shape;
+  using Alexandria::instrumentation;
+  using Tensor = Alexandria::Tensor<double>;
+
+  EXPECT_TRUE(Alexandria::Instrumentation::enabled());
+
+  const auto dense = Tensor::fill(Shape({4, 4}), 1.0);
+  auto sparse = Tensor::sparse(Shape({4, 4}));
+  for (auto index = 0ul; index < 4; ++index) sparse.set({index, index}, 2.0);
+  auto vector = Tensor::sparse(Shape({100}));
+  vector.set({3}, 1.0);
+  vector.set({7}, 2.0);
+
+  instrumentation().reset();
+  multiply(dense, {0, -1}, sparse, {-1, 1});
+  Alexandria::apply<double>(dense, [](double x) { return x + 1; });
+  const auto outer = multiply(vector, {0}, vector, {1});
+
+  const auto report = instrumentation().report();
+  ASSERT_EQ(report.count("multiply dense*sparse"), 1);
+  EXPECT_EQ(report.at("multiply dense*sparse").calls, 1);
+  EXPECT_EQ(report.at("multiply dense*sparse").elements, 16 * 4);
+  ASSERT_EQ(report.count("apply dense"), 1);
+  EXPECT_EQ(report.at("apply dense").elements, 16);
+  // The product fills its result, which is allocated dense.  Tensor has no
+  // move constructor, so dense is copied into apply and the result copied out
+  // of it, inside the timed scope.
+  EXPECT_EQ(report.at("dense allocate").calls, 3);
+  EXPECT_EQ(report.at("apply dense").bytes, 16 * sizeof(double));
+  // Only the outer product is sparse enough to be stored sparse.
+  ASSERT_TRUE(outer.isType<Tensor::Sparse>());
+  EXPECT_EQ(report.at("multiply sparse*sparse").calls, 1);
+  EXPECT_GT(report.at("sparse rehash").calls, 0);
+}
@@ -0,0 +1,118 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "util/arena.h"
+#include "util/profiler.h"
+
+namespace {
+template <typename T>
+struct Node {};
+
+struct Leaf : public Alexandria::ArenaAllocated {
+  double value;
+};
+}  // namespace
+
+TEST(Profiler, Scopes) {
+  using Alexandria::ProfileScope;
+  using Alexandria::Profiler;
+
+  {
+    // Not recorded without a profiler.
+    ProfileScope scope("evaluateAt", "Plus");
+    EXPECT_FALSE(scope.active());
+  }
+
+  Profiler profiler;
+  EXPECT_EQ(Profiler::current(), &profiler);
+  {
+    ProfileScope outer("evaluateAt", "Plus");
+    EXPECT_TRUE(outer.active());
+    delete new Leaf;
+    {
+      ProfileScope inner("evaluateAt", typeid(Node<int>));
+      inner.setOutput("dense", 3);
+      delete new Leaf;
+    }
+    ProfileScope sibling("simplify", "Const");
+  }
+
+  const auto& events = profiler.events();
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(events[0].name, "Plus");
+  EXPECT_EQ(events[0].parent, Profiler::kNoParent);
+  EXPECT_EQ(events[0].allocations, 2);
+  EXPECT_EQ(events[1].name, "Node");
+  EXPECT_EQ(events[1].parent, 0);
+  EXPECT_EQ(events[1].allocations, 1);
+  EXPECT_EQ(events[1].storage, "dense");
+  EXPECT_EQ(events[1].nnz, 3);
+  EXPECT_EQ(events[2].category, "simplify");
+  EXPECT_EQ(events[2].parent, 0);
+  EXPECT_GE(events[0].duration, events[1].duration + events[2].duration);
+
+  const auto summary = profiler.summary();
+  const auto& plus = summary.at({"evaluateAt", "Plus"});
+  EXPECT_EQ(plus.calls, 1);
+  EXPECT_EQ(plus.self_nanoseconds,
+            events[0].duration - events[1].duration - events[2].duration);
+
+  {
+    Profiler nested;
+    EXPECT_EQ(Profiler::current(), &nested);
+  }
+  EXPECT_EQ(Profiler::current(), &profiler);
+}
+
+TEST(Profiler, TypeName) {
+  using Alexandria::Profiler;
+
+  EXPECT_EQ(Profiler::typeName(typeid(Leaf)), "Leaf");
+  EXPECT_EQ(Profiler::typeName(typeid(Node<std::vector<int>>)), "Node");
+  EXPECT_EQ(Profiler::typeName(typeid(std::map<int, int>)), "map");
+}
+
+TEST(Profiler, Export) {
+  using Alexandria::ProfileScope;
+  using Alexandria::Profiler;
+
+  Profiler profiler;
+  for (auto index = 0; index < 2; ++index) {
+    ProfileScope outer("evaluateAt", "Plus");
+    ProfileScope inner("evaluateAt", "Var \"x\"");
+  }
+
+  std::ostringstream trace;
+  profiler.dumpChromeTrace(&trace);
+  const auto json = trace.str();
+  EXPECT_EQ(json.find("{\"traceEvents\": ["), 0);
+  EXPECT_NE(json.find("\"name\": \"Var \\\"x\\\"\""), std::string::npos);
+  EXPECT_NE(json.find("\"ph\": \"X\""), std::string::npos);
+
+  std::ostringstream folded;
+  profiler.dumpFolded(&folded);
+  std::istringstream lines(folded.str());
+  std::string line;
+  std::vector<std::string> stacks;
+  while (std::getline(lines, line)) {
+    stacks.emplace_back(line.substr(0, line.rfind(' ')));
+  }
+  EXPECT_EQ(stacks, std::vector<std::string>(
+                        {"evaluateAt Plus",
+                         "evaluateAt Plus;evaluateAt Var \"x\""}));
+
+  std::ostringstream text;
+  profiler.dumpSummary(&text);
+  EXPECT_NE(text.str().find("evaluateAt Plus: calls=2"), std::string::npos);
+}
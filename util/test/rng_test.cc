@@ -7,7 +7,11 @@
 #include "gtest/gtest.h"
 #pragma clang diagnostic pop
 
+#include <algorithm>
+#include <functional>
+#include <random>
 #include <sstream>
+#include <vector>
 
 #include "util/rng.h"
 
@@ -28,6 +32,7 @@ TEST(Rng, Serialize) {
 
   auto result = rng().generate(uniform_int_distribution<int>(-2, 4), 5);
 
+  ar_out.flush();
   istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
   ar_in % rng();
@@ -36,3 +41,63 @@ TEST(Rng, Serialize) {
 
   EXPECT_EQ(result, result_restore);
 }
+
+TEST(Rng, PhiloxKnownAnswers) {
+  using Alexandria::Philox;
+
+  // Test vectors from the Random123 distribution.
+  EXPECT_EQ(
+      Philox::block({{0, 0, 0, 0}}, {{0, 0}}),
+      (Philox::Counter{{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}));
+  EXPECT_EQ(
+      Philox::block({{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+                    {{0xffffffff, 0xffffffff}}),
+      (Philox::Counter{{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}));
+  EXPECT_EQ(
+      Philox::block({{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+                    {{0xa4093822, 0x299f31d0}}),
+      (Philox::Counter{{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}));
+}
+
+TEST(Rng, PhiloxOffset) {
+  using Alexandria::Philox;
+
+  Philox engine(42, 3);
+  std::vector<uint32_t> values(10);
+  std::generate(values.begin(), values.end(), std::ref(engine));
+  EXPECT_EQ(engine.offset(), 10ul);
+
+  // Any offset can be reached directly.
+  for (auto offset = 0ul; offset < values.size(); ++offset) {
+    EXPECT_EQ(Philox(42, 3, offset)(), values[offset]);
+  }
+
+  Philox skip(42, 3);
+  skip.discard(7);
+  EXPECT_EQ(skip(), values[7]);
+
+  // Streams are independent.
+  EXPECT_NE(Philox(42, 4)(), values[0]);
+}
+
+TEST(Rng, Reproducible) {
+  using std::normal_distribution;
+  using Alexandria::Rng;
+  using Alexandria::rng;
+
+  const auto n = 2 * Rng::kParallelThreshold + 3;
+
+  rng().seed(7);
+  auto small = rng().generate(normal_distribution<double>(), Rng::kChunkSize);
+  auto large1 = rng().generate(normal_distribution<double>(), n);
+
+  rng().seed(7);
+  auto large0 = rng().generate(normal_distribution<double>(), n);
+  auto large2 = rng().generate(normal_distribution<double>(), n);
+
+  // A chunk does not depend on how much else is generated or on which thread
+  // generates it.
+  EXPECT_TRUE(std::equal(small.cbegin(), small.cend(), large0.cbegin()));
+  EXPECT_EQ(large1, large2);
+  EXPECT_NE(large0, large1);
+}
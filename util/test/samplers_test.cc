@@ -0,0 +1,106 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wundef"
+#pragma clang diagnostic ignored "-Wdeprecated"
+#pragma clang diagnostic ignored "-Wmissing-noreturn"
+#pragma clang diagnostic ignored "-Wshift-sign-overflow"
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "gtest/gtest.h"
+#pragma clang diagnostic pop
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "util/rng.h"
+#include "util/samplers.h"
+
+namespace {
+// Kolmogorov-Smirnov statistic of values against cdf.
+template <typename T>
+double ksStatistic(std::vector<T> values, std::function<double(double)> cdf) {
+  std::sort(values.begin(), values.end());
+  const auto n = static_cast<double>(values.size());
+  auto statistic = 0.0;
+  for (auto index = 0ul; index < values.size(); ++index) {
+    const auto expected = cdf(static_cast<double>(values[index]));
+    statistic = std::max({statistic, (index + 1) / n - expected,
+                          expected - index / n});
+  }
+  return statistic;
+}
+
+template <typename T>
+std::pair<double, double> moments(const std::vector<T>& values) {
+  auto mean = 0.0;
+  for (auto value : values) mean += value;
+  mean /= values.size();
+  auto variance = 0.0;
+  for (auto value : values) variance += (value - mean) * (value - mean);
+  return {mean, variance / (values.size() - 1)};
+}
+
+double normalCdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+// Critical value of the statistic at the 1% level.
+double ksCritical(size_t n) { return 1.63 / std::sqrt(static_cast<double>(n)); }
+}  // namespace
+
+TEST(Samplers, Uniform) {
+  using Alexandria::Philox;
+  namespace Samplers = Alexandria::Samplers;
+
+  const auto n = 100001ul;
+  std::vector<double> values(n);
+  Philox engine(11);
+  Samplers::uniform(engine, -1.0, 3.0, values.data(), values.data() + n);
+
+  EXPECT_GE(*std::min_element(values.cbegin(), values.cend()), -1.0);
+  EXPECT_LT(*std::max_element(values.cbegin(), values.cend()), 3.0);
+
+  auto mean_variance = moments(values);
+  EXPECT_NEAR(mean_variance.first, 1.0, 0.02);
+  EXPECT_NEAR(mean_variance.second, 16.0 / 12.0, 0.02);
+  EXPECT_LT(ksStatistic(values, [](double x) { return (x + 1) / 4; }),
+            ksCritical(n));
+
+  std::vector<float> floats(n);
+  Samplers::uniform(engine, 0.0f, 1.0f, floats.data(), floats.data() + n);
+  EXPECT_LT(ksStatistic(floats, [](double x) { return x; }), ksCritical(n));
+}
+
+TEST(Samplers, Normal) {
+  using Alexandria::Philox;
+  namespace Samplers = Alexandria::Samplers;
+
+  const auto n = 100001ul;
+  std::vector<double> values(n);
+  Philox engine(13);
+  Samplers::normal(engine, 2.0, 3.0, values.data(), values.data() + n);
+
+  auto mean_variance = moments(values);
+  EXPECT_NEAR(mean_variance.first, 2.0, 0.05);
+  EXPECT_NEAR(mean_variance.second, 9.0, 0.15);
+  EXPECT_LT(ksStatistic(values,
+                        [](double x) { return normalCdf((x - 2.0) / 3.0); }),
+            ksCritical(n));
+
+  std::vector<float> floats(n);
+  Samplers::normal(engine, 0.0f, 1.0f, floats.data(), floats.data() + n);
+  EXPECT_LT(ksStatistic(floats, normalCdf), ksCritical(n));
+}
+
+TEST(Samplers, Rng) {
+  using std::normal_distribution;
+  using std::uniform_real_distribution;
+  using Alexandria::rng;
+
+  // The bulk samplers back the standard real distributions in Rng.
+  const auto n = 50000ul;
+  auto uniform = rng().generate(uniform_real_distribution<double>(0, 1), n);
+  EXPECT_LT(ksStatistic(uniform, [](double x) { return x; }), ksCritical(n));
+
+  auto normal = rng().generate(normal_distribution<double>(), n);
+  EXPECT_LT(ksStatistic(normal, normalCdf), ksCritical(n));
+}
@@ -43,6 +43,7 @@ TEST(Serializable, Class) {
   ArchiveOut ar_out(&sout);
   ar_out % class_out;
 
+  ar_out.flush();
   istringstream sin(sout.str());
   ArchiveIn ar_in(&sin);
   TestClass class_in;